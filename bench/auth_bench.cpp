@@ -0,0 +1,37 @@
+// Measures password verification throughput (logins/sec) for the scrypt-based
+// PasswordHasher, single-threaded and on a pool sized to the machine.
+// Usage: auth_bench [cost] [logins]
+#include "passwordhash.hpp"
+#include "threadpool.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+int main(int argc, char** argv) {
+    int cost = argc > 1 ? std::atoi(argv[1]) : PasswordHasher::DEFAULT_COST;
+    int logins = argc > 2 ? std::atoi(argv[2]) : 64;
+    std::string record = PasswordHasher::hash("correct horse", cost);
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < logins; ++i) {
+        PasswordHasher::verify("correct horse", record);
+    }
+    double singleSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    ThreadPool pool;
+    start = std::chrono::steady_clock::now();
+    std::vector<std::future<bool>> results;
+    for (int i = 0; i < logins; ++i) {
+        results.push_back(pool.submit([&record]() { return PasswordHasher::verify("correct horse", record); }));
+    }
+    for (auto& result : results) result.get();
+    double poolSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    double singleRate = logins / singleSeconds;
+    double poolRate = logins / poolSeconds;
+    std::cout << "cost=" << cost << " (N=2^" << cost << ", " << ((128 * 8) << cost) / (1024 * 1024) << " MiB per login)" << std::endl;
+    std::cout << "1 thread:   " << singleRate << " logins/sec (" << 1000.0 / singleRate << " ms each)" << std::endl;
+    std::cout << pool.size() << " threads: " << poolRate << " logins/sec, " << poolRate / pool.size() << " logins/sec per core" << std::endl;
+    return 0;
+}
@@ -0,0 +1,103 @@
+// Measures credential lookup throughput under contention: a single mutex around
+// an unordered_map (the old access pattern made thread-safe) versus the
+// lock-striped CredentialStore, at 1 to 32 threads. Each operation is a lookup
+// with a configurable share of writes mixed in.
+// Usage: credential_bench [users] [operations per thread] [write percent]
+#include "credentialstore.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+struct Record {
+    std::string passwordHash;
+    int role;
+};
+
+class SingleLockStore {
+public:
+    bool find(const std::string& key, Record& value) const {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = entries.find(key);
+        if (it == entries.end()) return false;
+        value = it->second;
+        return true;
+    }
+    void put(const std::string& key, const Record& value) {
+        std::lock_guard<std::mutex> lock(mutex);
+        entries[key] = value;
+    }
+
+private:
+    mutable std::mutex mutex;
+    std::unordered_map<std::string, Record> entries;
+};
+
+template <typename Store>
+double run(Store& store, const std::vector<std::string>& names, int threads, int operations, int writePercent) {
+    std::atomic<int> ready(0);
+    std::atomic<bool> go(false);
+    std::atomic<long> found(0);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t]() {
+            // Cheap per-thread LCG so the generator itself is not a shared hot spot
+            unsigned long long state = 0x9e3779b97f4a7c15ULL * (t + 1);
+            Record record;
+            long hits = 0;
+            ready++;
+            while (!go) std::this_thread::yield();
+            for (int i = 0; i < operations; ++i) {
+                state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+                const std::string& name = names[(state >> 33) % names.size()];
+                if (static_cast<int>((state >> 20) % 100) < writePercent) {
+                    store.put(name, Record{"scrypt$14$00$00", 0});
+                } else if (store.find(name, record)) {
+                    hits++;
+                }
+            }
+            found += hits;
+        });
+    }
+    while (ready < threads) std::this_thread::yield();
+    auto start = std::chrono::steady_clock::now();
+    go = true;
+    for (auto& worker : workers) worker.join();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return threads * static_cast<double>(operations) / seconds;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int userCount = argc > 1 ? std::atoi(argv[1]) : 10000;
+    int operations = argc > 2 ? std::atoi(argv[2]) : 200000;
+    int writePercent = argc > 3 ? std::atoi(argv[3]) : 5;
+
+    std::vector<std::string> names;
+    SingleLockStore single;
+    CredentialStore<Record> striped;
+    for (int i = 0; i < userCount; ++i) {
+        names.push_back("user" + std::to_string(i));
+        single.put(names.back(), Record{"scrypt$14$00$00", 0});
+        striped.put(names.back(), Record{"scrypt$14$00$00", 0});
+    }
+
+    std::cout << userCount << " users, " << operations << " ops/thread, " << writePercent << "% writes, "
+              << std::thread::hardware_concurrency() << " hardware threads" << std::endl;
+    std::cout << "threads   single mutex (ops/s)   striped x" << CredentialStore<Record>::STRIPE_COUNT << " (ops/s)   speedup" << std::endl;
+    for (int threads : {1, 2, 4, 8, 16, 32}) {
+        double singleRate = run(single, names, threads, operations, writePercent);
+        double stripedRate = run(striped, names, threads, operations, writePercent);
+        std::cout << threads << "\t  " << static_cast<long>(singleRate) << "\t\t\t " << static_cast<long>(stripedRate)
+                  << "\t\t\t " << stripedRate / singleRate << "x" << std::endl;
+    }
+    return 0;
+}
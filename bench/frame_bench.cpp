@@ -0,0 +1,195 @@
+// Measures the CPU side of a dashboard frame without a display: DashboardView
+// is driven the way gui_main.cpp drives it, over synthetic rooms, accounts and
+// history, and every heap allocation made during the timed frames is counted.
+// Drawing itself (raylib) is not included.
+// Runs in a scratch directory under the system temp path, never in ./output.
+// Usage: frame_bench [rooms] [accounts] [frames]
+#include "dashboardview.hpp"
+#include "durability.hpp"
+#include "meetingroom.hpp"
+#include "passwordhash.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+
+namespace {
+
+std::atomic<std::size_t> allocations{0};
+
+struct Cost {
+    double microseconds;  // Per frame
+    double allocations;   // Per frame
+};
+
+// Runs frame(i) for every frame and reports the averages
+template <typename Frame>
+Cost measure(int frames, Frame frame) {
+    frame(0); // Warm up caches and buffers
+    std::size_t allocationsBefore = allocations.load();
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 1; i <= frames; ++i) {
+        frame(i);
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return Cost{seconds * 1e6 / frames, (double)(allocations.load() - allocationsBefore) / frames};
+}
+
+void report(const char* scenario, const Cost& cost) {
+    std::printf("%-26s %12.2f %14.2f\n", scenario, cost.microseconds, cost.allocations);
+}
+
+} // namespace
+
+void* operator new(std::size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* memory = std::malloc(size ? size : 1)) return memory;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept {
+    std::free(memory);
+}
+
+int main(int argc, char** argv) {
+    int roomCount = argc > 1 ? std::atoi(argv[1]) : 50000;
+    int accountCount = argc > 2 ? std::atoi(argv[2]) : 2000;
+    int frames = argc > 3 ? std::atoi(argv[3]) : 2000;
+
+    std::filesystem::path scratch = std::filesystem::temp_directory_path() / "ifm_frame_bench";
+    std::filesystem::remove_all(scratch);
+    std::filesystem::create_directories(scratch / "output");
+    std::filesystem::current_path(scratch);
+    Durability::configure(Durability::Level::NONE);
+
+    // Synthetic site: rooms of assorted sizes, every seventh one booked, plus accounts
+    Authentication auth;
+    RoomManager rm;
+    RoomBookingSystem bookingSystem(rm);
+    OfflineManager offline(auth, rm, bookingSystem);
+    std::cout.setstate(std::ios::failbit); // Room and booking calls print a line each
+    rm.beginBatch();
+    for (int i = 0; i < roomCount; ++i) {
+        rm.addRoom("bench", "room" + std::to_string(i), 2 + i % 20, true);
+    }
+    for (int i = 0; i < roomCount; i += 7) {
+        bookingSystem.bookRoom("user" + std::to_string(i % 500), 1, "room" + std::to_string(i));
+    }
+    rm.endBatch();
+    std::cout.clear();
+
+    {
+        std::FILE* csv = std::fopen("accounts.csv", "w");
+        for (int i = 0; i < accountCount; ++i) {
+            std::fprintf(csv, "account%d,secret%d,%s\n", i, i, i % 10 == 0 ? "admin" : "user");
+        }
+        std::fclose(csv);
+        auth.setHashCost(Authentication::Role::USER, PasswordHasher::MIN_COST);
+        auth.setHashCost(Authentication::Role::ADMIN, PasswordHasher::MIN_COST);
+        Authentication::ImportReport importReport;
+        auth.importUsers("accounts.csv", importReport);
+    }
+
+    DashboardView view(rm, offline);
+    Replicator::Stats replicationStats;
+    DashboardView::Layout layout; // The floor plan area of a 1280x720 window
+    layout.x = 276;
+    layout.y = 250;
+    layout.width = 984;
+    layout.height = 450;
+    DashboardView::Filter filter;
+
+    auto frame = [&]() -> const std::vector<DashboardView::Tile>& {
+        view.updateStatus(&replicationStats);
+        view.updateFloorPlan(filter);
+        view.getContentHeight(layout);
+        return view.layoutTiles(layout);
+    };
+
+    std::cout << roomCount << " rooms, " << accountCount << " accounts, " << frames << " frames per scenario" << std::endl;
+    std::printf("%-26s %12s %14s\n", "scenario", "us/frame", "allocs/frame");
+
+    report("idle", measure(frames, [&](int) { frame(); }));
+
+    report("scrolling", measure(frames, [&](int i) {
+        layout.scrollY = -(float)((i * 37) % 200000);
+        frame();
+    }));
+    layout.scrollY = 0;
+
+    // Typing in the search box: the filter runs on every frame
+    const char* searches[] = { "r", "ro", "roo", "room", "room1", "room12", "room123", "ROOM4" };
+    report("search typing", measure(frames / 10, [&](int i) {
+        filter.search = searches[i % 8];
+        frame();
+    }));
+    filter.search = "";
+
+    filter.availableOnly = true;
+    filter.minCapacity = "12";
+    report("filtered idle", measure(frames, [&](int) { frame(); }));
+    filter.availableOnly = false;
+    filter.minCapacity = "";
+
+    // A booking or release lands every frame, so the room version moves; the
+    // batch keeps rooms.txt from being rewritten, which is not frame cost
+    std::cout.setstate(std::ios::failbit);
+    rm.beginBatch();
+    report("booking churn", measure(frames / 10, [&](int i) {
+        std::string room = "room" + std::to_string(1 + (i % 6)); // Never one of the pre-booked rooms
+        if (i % 2 == 0) {
+            bookingSystem.bookRoom("churn", 1, room);
+        } else {
+            bookingSystem.releaseRoom("churn", room, true);
+        }
+        frame();
+    }));
+    rm.endBatch();
+
+    // Offline with queued changes: the floor plan shows the projected rooms
+    offline.goOffline();
+    for (int i = 0; i < 1000; ++i) {
+        offline.queueModifyRoom("bench", "room" + std::to_string(i * 13 % roomCount), 30, true);
+    }
+    std::cout.clear();
+    report("offline idle", measure(frames, [&](int) { frame(); }));
+
+    // Popups fetching and formatting a page of rows
+    RoomHistoryManager roomHistory;
+    BookingHistoryManager bookingHistory;
+    std::vector<std::string> rows;
+    report("room history page", measure(frames / 20, [&](int i) {
+        HistoryQuery query;
+        query.offset = (std::size_t)(i * 100) % roomCount;
+        query.limit = 100;
+        rows.clear();
+        for (const auto& entry : roomHistory.queryHistory(query).entries) rows.push_back(DashboardView::formatRoomHistory(entry));
+    }));
+    report("booking history page", measure(frames / 20, [&](int i) {
+        HistoryQuery query;
+        query.offset = (std::size_t)(i * 100) % (roomCount / 7 + 1);
+        query.limit = 100;
+        rows.clear();
+        for (const auto& entry : bookingHistory.queryHistory(query).entries) rows.push_back(DashboardView::formatBookingHistory(entry));
+    }));
+    report("accounts page", measure(frames, [&](int i) {
+        rows.clear();
+        for (const auto& entry : auth.queryUsers("account1", UserDirectory::ANY_ROLE, (std::size_t)(i * 17) % 1000, 17)) {
+            rows.push_back(DashboardView::formatAccount(entry));
+        }
+    }));
+
+    std::cout << "room filter ran " << view.getFilterRuns() << " times" << std::endl;
+    std::filesystem::current_path(std::filesystem::temp_directory_path());
+    std::filesystem::remove_all(scratch);
+    return 0;
+}
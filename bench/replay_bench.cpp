@@ -0,0 +1,103 @@
+// Measures offline queue replay: the same queue of room and account changes is
+// synchronized with 1, 2, 4, ... replay threads. Room ops are spread over many
+// rooms in a pattern compaction cannot fold away; account ops register and
+// then edit admins, so they include a password hash each.
+// Runs in a scratch directory under the system temp path, never in ./output.
+// Usage: replay_bench [queued ops] [rooms] [account op percent] [hash cost]
+#include "offlinemechanism.hpp"
+#include "durability.hpp"
+#include "threadpool.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Result {
+    double seconds;
+    std::size_t replayed;
+};
+
+Result run(std::size_t threads, int operations, int roomCount, int accountPercent, int hashCost) {
+    std::error_code ec;
+    std::filesystem::remove_all("output", ec);
+    std::filesystem::create_directory("output");
+
+    Authentication auth;
+    auth.setHashCost(Authentication::Role::ADMIN, hashCost);
+    auth.setHashCost(Authentication::Role::USER, hashCost);
+    RoomManager rm;
+    RoomBookingSystem rbs(rm);
+    OfflineManager offline(auth, rm, rbs);
+    offline.setReplayThreads(threads);
+    for (int i = 0; i < roomCount; ++i) {
+        rm.addRoom("bench", "room" + std::to_string(i), 10, true);
+    }
+
+    std::cout.setstate(std::ios::failbit); // Replay prints a line per op
+    offline.goOffline();
+    // Per room: MODIFY, BOOK, MODIFY, RELEASE, ... never two foldable ops in a row
+    std::vector<int> step(roomCount, 0);
+    int accounts = 0;
+    unsigned long long state = 0x9e3779b97f4a7c15ULL;
+    for (int i = 0; i < operations; ++i) {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        if (static_cast<int>((state >> 33) % 100) < accountPercent) {
+            std::string name = "admin" + std::to_string(accounts / 2);
+            if (accounts++ % 2 == 0) {
+                offline.queueRegisterNewAdmin("bench", name, "secret");
+            } else {
+                offline.queueEditUser(name, "secret2", Authentication::Role::ADMIN);
+            }
+            continue;
+        }
+        int room = static_cast<int>((state >> 20) % roomCount);
+        std::string name = "room" + std::to_string(room);
+        switch (step[room]++ % 4) {
+            case 0: offline.queueModifyRoom("bench", name, 12, true); break;
+            case 1: offline.queueBookRoom("user" + std::to_string(room), 4, name); break;
+            case 2: offline.queueModifyRoom("bench", name, 14, false); break;
+            default: offline.queueReleaseRoom("user" + std::to_string(room), name); break;
+        }
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    offline.goOnline();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::size_t replayed = offline.getSyncProgress().total;
+    std::cout.clear();
+    return Result{seconds, replayed};
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int operations = argc > 1 ? std::atoi(argv[1]) : 100000;
+    int roomCount = argc > 2 ? std::atoi(argv[2]) : 2000;
+    int accountPercent = argc > 3 ? std::atoi(argv[3]) : 2;
+    int hashCost = argc > 4 ? std::atoi(argv[4]) : 10;
+
+    std::filesystem::path scratch = std::filesystem::temp_directory_path() / "ifm_replay_bench";
+    std::filesystem::create_directories(scratch);
+    std::filesystem::current_path(scratch);
+    Durability::configure(Durability::Level::NONE);
+
+    std::cout << operations << " queued ops over " << roomCount << " rooms, " << accountPercent << "% account ops (hash cost "
+              << hashCost << "), " << ThreadPool::defaultThreadCount() << " hardware threads" << std::endl;
+    std::cout << "threads   replayed   seconds   ops/s   speedup" << std::endl;
+    double serialSeconds = 0;
+    std::vector<std::size_t> threadCounts{1, 2, 4, 8};
+    if (ThreadPool::defaultThreadCount() > 8) threadCounts.push_back(ThreadPool::defaultThreadCount());
+    for (std::size_t threads : threadCounts) {
+        Result result = run(threads, operations, roomCount, accountPercent, hashCost);
+        if (threads == 1) serialSeconds = result.seconds;
+        std::cout << threads << "\t  " << result.replayed << "\t     " << result.seconds << "\t" << static_cast<long>(result.replayed / result.seconds)
+                  << "\t" << serialSeconds / result.seconds << "x" << std::endl;
+    }
+    std::filesystem::current_path(std::filesystem::temp_directory_path());
+    std::filesystem::remove_all(scratch);
+    return 0;
+}
@@ -1,2 +1,2 @@
 if not exist output mkdir output
-g++ -std=c++17 -Iinclude -Isrc -o output\intelligent_floor_plan.exe src\auth.cpp src\floorplan.cpp src\main.cpp src\meetingroom.cpp src\offlinemechanism.cpp src\ui.cpp
\ No newline at end of file
+g++ -std=c++17 -Iinclude -Isrc -o output\intelligent_floor_plan.exe src\auth.cpp src\floorplan.cpp src\main.cpp src\meetingroom.cpp src\offlinemechanism.cpp src\offlineoverlay.cpp src\compression.cpp src\ui.cpp src\durability.cpp src\passwordhash.cpp src\oscrypto.cpp src\threadpool.cpp src\session.cpp src\userdirectory.cpp -lbcrypt
\ No newline at end of file
@@ -0,0 +1,6 @@
+@echo off
+if not exist output mkdir output
+g++ -std=c++17 -O2 -Iinclude -Isrc bench/auth_bench.cpp src/passwordhash.cpp src/oscrypto.cpp src/threadpool.cpp -o output/auth_bench.exe -lbcrypt -Wall -Wextra
+g++ -std=c++17 -O2 -Iinclude -Isrc bench/credential_bench.cpp -o output/credential_bench.exe -Wall -Wextra
+g++ -std=c++17 -O2 -Iinclude -Isrc bench/replay_bench.cpp src/auth.cpp src/room.cpp src/meetingroom.cpp src/offlinemechanism.cpp src/offlineoverlay.cpp src/compression.cpp src/ui.cpp src/history.cpp src/threadpool.cpp src/durability.cpp src/passwordhash.cpp src/oscrypto.cpp src/session.cpp src/userdirectory.cpp -o output/replay_bench.exe -lbcrypt -Wall -Wextra
+g++ -std=c++17 -O2 -Iinclude -Isrc bench/frame_bench.cpp src/dashboardview.cpp src/auth.cpp src/room.cpp src/meetingroom.cpp src/offlinemechanism.cpp src/offlineoverlay.cpp src/compression.cpp src/ui.cpp src/history.cpp src/threadpool.cpp src/durability.cpp src/passwordhash.cpp src/oscrypto.cpp src/session.cpp src/userdirectory.cpp -o output/frame_bench.exe -lbcrypt -Wall -Wextra
\ No newline at end of file
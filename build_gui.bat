@@ -1,3 +1,3 @@
 @echo off
 if not exist output mkdir output
-g++ -std=c++17 -Iinclude -Isrc -Llib gui_main.cpp src/auth.cpp src/room.cpp src/meetingroom.cpp src/offlinemechanism.cpp src/ui.cpp src/history.cpp -o output/ifm_gui.exe -lraylib -lopengl32 -lgdi32 -lwinmm -Wall -Wextra
\ No newline at end of file
+g++ -std=c++17 -Iinclude -Isrc -Llib gui_main.cpp src/auth.cpp src/room.cpp src/meetingroom.cpp src/offlinemechanism.cpp src/offlineoverlay.cpp src/compression.cpp src/dashboardview.cpp src/virtuallist.cpp src/tilecache.cpp src/idlemode.cpp src/replication.cpp src/ui.cpp src/history.cpp src/threadpool.cpp src/durability.cpp src/passwordhash.cpp src/oscrypto.cpp src/session.cpp src/userdirectory.cpp -o output/ifm_gui.exe -lraylib -lopengl32 -lgdi32 -lwinmm -lws2_32 -lbcrypt -Wall -Wextra
\ No newline at end of file
@@ -4,12 +4,20 @@
 #include "meetingroom.hpp"
 #include "offlinemechanism.hpp"
 #include "history.hpp"
+#include "durability.hpp"
+#include "replication.hpp"
+#include "virtuallist.hpp"
+#include "tilecache.hpp"
+#include "idlemode.hpp"
+#include "dashboardview.hpp"
 #include <random>   // For random number generation
 #include <algorithm> // For std::transform
 #include <chrono>   // For seeding the random number generator
 #include <vector>
 #include <string>
 #include <iostream>
+#include <future>
+#include <mutex>
 
 // Force include dependencies for raygui implementation
 #include <stdlib.h> // Required for: strtod
@@ -38,12 +46,17 @@ int main() {
     InitWindow(screenWidth, screenHeight, "Intelligent Floor Plan Management");
 
     SetTargetFPS(60);
+    Durability::configureFromEnvironment(); // IFM_DURABILITY=none|group[:ms]|fsync
+    Durability::recover(); // Finishes a commit cut short by a crash
 
     // Application State
     AppState currentState = AppState::LOGIN;
     Authentication auth;
     RoomManager roomManager;
     RoomBookingSystem bookingSystem(roomManager);
+    // Declared before the offline manager so a running sync is joined while the replicator still observes rooms
+    Replicator replicator(roomManager);
+    bool replicating = replicator.configureFromEnvironment(); // IFM_REPLICA_LISTEN=[host:]port, IFM_REPLICA_PEER=host:port
     OfflineManager offlineManager(auth, roomManager, bookingSystem);
     RoomHistoryManager roomHistoryManager;
     BookingHistoryManager bookingHistoryManager;
@@ -55,17 +68,23 @@ int main() {
     bool usernameBoxEditMode = false;
     std::string loginMessage = "";
     bool isAdminLogin = false;
+    std::future<Authentication::LoginResult> pendingLogin; // In-flight credential verification
+    std::string pendingLoginUser;
+    bool pendingLoginAsAdmin = false;
+    std::future<std::string> pendingRegister; // In-flight password hash for the Register button
+    std::string pendingRegisterUser;
     std::string statusMessage = ""; // To display online/offline status
 
     // Dashboard state
     std::string loggedInUser;
-    Vector2 scroll = { 0, 0 };
+    std::string sessionToken; // Issued at login; revoked if the account is edited or deleted
 
     // Room creation state
     bool showAddRoomPopup = false;
     char roomName[64] = "";
     char roomCapacity[10] = "";
     bool roomNameBoxEditMode = false;
+    std::string addRoomMessage = "";
 
     // Admin Management state
     bool showAddAdminPopup = false;
@@ -74,6 +93,9 @@ int main() {
     bool newAdminUsernameEditMode = false;
     bool newAdminPasswordEditMode = false;
     std::string addAdminMessage = "";
+    std::future<std::string> pendingAddAdmin; // Hashes on the auth pool; stored once ready
+    std::string pendingAddAdminUser;
+    std::string pendingAddAdminPassword; // Queued instead if the app went offline meanwhile
 
     bool showDeleteUserAdminPopup = false;
     char deleteTargetUsername[64] = "";
@@ -87,9 +109,31 @@ int main() {
     bool editTargetUsernameEditMode = false;
     bool editNewPasswordEditMode = false;
     std::string editUserAdminMessage = "";
+    std::future<std::string> pendingEdit;
+    std::string pendingEditUser;
+    std::string pendingEditPassword;
+    Authentication::Role pendingEditRole = Authentication::Role::USER;
 
     bool showViewUsersAdminsPopup = false;
-    std::vector<std::string> usersAdminsDisplayList;
+    VirtualList usersAdminsList; // Only the rows of the current page
+    char usersAdminsSearch[64] = "";
+    bool usersAdminsSearchEditMode = false;
+    int usersAdminsRoleFilter = 0; // 0 all, 1 users, 2 admins (GuiToggleGroup)
+    std::size_t usersAdminsPage = 0;
+    std::size_t usersAdminsTotal = 0;
+    bool usersAdminsNeedsFetch = true;
+    std::string usersAdminsFetchedSearch; // Inputs of the cached page
+    int usersAdminsFetchedRole = -1;
+    std::size_t usersAdminsFetchedPageSize = 0;
+    std::uint64_t usersAdminsFetchedVersion = 0;
+
+    bool showImportUsersPopup = false;
+    char importUsersPath[256] = "";
+    bool importUsersPathEditMode = false;
+    std::string importUsersMessage = "";
+    std::vector<std::string> importUsersErrors;
+    std::future<Authentication::PreparedImport> pendingImport; // Reads and hashes off the GUI thread
+    Authentication::ImportProgress importProgress;
     // Room modification state
     bool showModifyRoomPopup = false;
     char modifyRoomName[64] = "";
@@ -114,19 +158,26 @@ int main() {
     bool showReleaseStatusPopup = false;
     // View Offline Queue state
     bool showOfflineQueuePopup = false;
+    VirtualList offlineQueueList;
 
     // Room deletion state
     bool showRoomHistoryPopup = false;
-    Vector2 roomHistoryScroll = { 0, 0 };
-    std::vector<std::string> roomHistoryDisplayList;
+    VirtualList roomHistoryList;
+    const std::size_t historyPageSize = 100; // Entries fetched per history page
+    std::size_t roomHistoryPage = 0;
+    std::size_t roomHistoryTotal = 0;
+    bool roomHistoryNeedsFetch = false;
 
     // Booking history state
     bool showBookingHistoryPopup = false;
-    Vector2 bookingHistoryScroll = { 0, 0 };
+    VirtualList bookingHistoryList;
+    std::size_t bookingHistoryPage = 0;
+    std::size_t bookingHistoryTotal = 0;
+    bool bookingHistoryNeedsFetch = false;
     bool showDeleteRoomPopup = false;
     char deleteRoomName[64] = "";
     bool deleteRoomNameEditMode = false;
-    Vector2 usersAdminsScroll = { 0, 0 };
+    std::string deleteRoomMessage = "";
 
     // Room Search and Filter state
     char searchRoomName[64] = "";
@@ -137,6 +188,8 @@ int main() {
     bool filterCapacityEditMode = false;
     // Random offline simulation state
     Vector2 floorPlanScroll = { 0, 0 };
+    TileCache roomTiles(180, 100); // Same size as the floor plan's room boxes
+    DashboardView dashboardView(roomManager, offlineManager); // Floor plan, status lines and popup rows
 
     // Random offline simulation state
     std::default_random_engine generator(std::chrono::system_clock::now().time_since_epoch().count());
@@ -145,16 +198,89 @@ int main() {
     std::uniform_int_distribution<int> goOfflineChanceDist(1, 100);            // 40% chance to go offline
 
     float statusChangeTimer = onlineDurationDist(generator); // Time until next status event
+    // Wall-clock time, since GetFrameTime() leaves out the time spent waiting for events
+    double lastUpdateTime = GetTime();
+
+    // Changes made off the GUI thread that need a redraw while the loop is waiting
+    IdleMode::configureFromEnvironment(); // IFM_RENDER=idle|continuous
+    IdleMode::watch([&roomManager]() { return roomManager.getVersion(); });
+    IdleMode::watch([&offlineManager]() {
+        OfflineManager::SyncProgress progress = offlineManager.getSyncProgress();
+        return (std::uint64_t)progress.applied * 2 + (progress.running ? 1 : 0);
+    });
+    IdleMode::watch([&replicator]() { return replicator.getStats().bytesReceived; });
 
     //--------------------------------------------------------------------------------------
 
     // Main game loop
     while (!WindowShouldClose()) {
+        // Rooms, bookings and the offline queue may be mutated by the background
+        // sync worker; the frame owns them until just before EndDrawing()
+        std::unique_lock<std::mutex> stateLock = offlineManager.acquireState();
+
         // Update
         //----------------------------------------------------------------------------------
+        // Peers are only talked to while online; changes made meanwhile are sent on reconnect
+        replicator.setPaused(offlineManager.isOffline());
+        replicator.poll();
+
+        // Admin registrations and edits finish here, so closing the popup does not drop them
+        if (pendingAddAdmin.valid() && pendingAddAdmin.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+            std::string passwordHash = pendingAddAdmin.get();
+            if (offlineManager.isOffline()) {
+                addAdminMessage = offlineManager.queueRegisterNewAdmin(loggedInUser, pendingAddAdminUser, pendingAddAdminPassword)
+                    ? "Admin registration queued." : "Offline queue is full. Registration not queued.";
+            } else if (auth.completeRegister(pendingAddAdminUser, passwordHash, Authentication::Role::ADMIN)) {
+                addAdminMessage = "Admin registered successfully!";
+            } else {
+                addAdminMessage = "Admin registration failed (username exists).";
+            }
+            pendingAddAdminPassword.clear();
+        }
+        if (pendingEdit.valid() && pendingEdit.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+            std::string passwordHash = pendingEdit.get();
+            if (offlineManager.isOffline()) {
+                editUserAdminMessage = offlineManager.queueEditUser(pendingEditUser, pendingEditPassword, pendingEditRole)
+                    ? "Modification queued." : "Offline queue is full. Modification not queued.";
+            } else if (auth.completeEditUser(pendingEditUser, passwordHash, pendingEditRole)) {
+                editUserAdminMessage = "User/Admin modified successfully.";
+            } else {
+                editUserAdminMessage = "User/Admin not found.";
+            }
+            pendingEditPassword.clear();
+        }
+        if (pendingImport.valid() && pendingImport.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+            Authentication::PreparedImport prepared = pendingImport.get();
+            importUsersErrors.clear();
+            if (!prepared.opened) {
+                importUsersMessage = "Unable to open the import file.";
+            } else if (offlineManager.isOffline()) {
+                // Imports bypass the offline queue, so one that outlived the connection is dropped
+                importUsersMessage = "Went offline during the import. Nothing was imported.";
+            } else {
+                Authentication::ImportReport report;
+                bool saved = auth.completeImport(prepared, report);
+                importUsersMessage = !saved ? "Unable to save the imported accounts." :
+                                     "Imported " + std::to_string(report.imported) + " of " + std::to_string(report.rowsRead) +
+                                     " rows (" + std::to_string((int)report.rowsPerSecond()) + " rows/s)";
+                for (const auto& error : report.errors) {
+                    importUsersErrors.push_back("Line " + std::to_string(error.line) + ": " + error.message);
+                }
+            }
+        }
+
+        // A worker finishing posts no event, so keep polling until every pending result is in
+        if (pendingLogin.valid() || pendingRegister.valid() || pendingAddAdmin.valid() || pendingEdit.valid() || pendingImport.valid()) {
+            IdleMode::keepAwake();
+        }
+
         // Handle state transitions and logic
-        if (currentState != AppState::LOGIN) {
-            statusChangeTimer -= GetFrameTime();
+        // (with a real peer configured connectivity is no longer simulated)
+        double updateTime = GetTime();
+        float elapsed = (float)(updateTime - lastUpdateTime);
+        lastUpdateTime = updateTime;
+        if (currentState != AppState::LOGIN && !replicating) {
+            statusChangeTimer -= elapsed;
 
             if (statusChangeTimer <= 0.0f) {
                 if (!offlineManager.isOffline()) {
@@ -168,10 +294,11 @@ int main() {
                     }
                 } else {
                     // Currently offline, time to go back online
-                    offlineManager.goOnline();
+                    offlineManager.goOnlineInBackground();
                     statusChangeTimer = onlineDurationDist(generator); // Set how long to stay online
                 }
             }
+            IdleMode::wakeAfter(statusChangeTimer); // The next connectivity change has to be drawn
         }
         //----------------------------------------------------------------------------------
 
@@ -222,12 +349,27 @@ int main() {
                 GuiSetStyle(DEFAULT, TEXT_SIZE, 10); // Reset to default
 
                 // Login Button
-                if (GuiButton(Rectangle{ startX, startY + 2 * (boxHeight + spacing) + 50, buttonWidth, buttonHeight }, "Login")) {
-                    if (auth.login(username, password, isAdminLogin)) {
+                if (GuiButton(Rectangle{ startX, startY + 2 * (boxHeight + spacing) + 50, buttonWidth, buttonHeight }, "Login") && !pendingLogin.valid()) {
+                    // Password verification is deliberately slow, so it runs on the auth worker pool
+                    pendingLogin = auth.loginUserAsync(username, password);
+                    pendingLoginUser = username;
+                    pendingLoginAsAdmin = isAdminLogin;
+                    loginMessage = "Verifying credentials...";
+                }
+                if (pendingLogin.valid() && pendingLogin.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+                    Authentication::LoginResult result = pendingLogin.get();
+                    Authentication::Role role;
+                    bool roleMatches = false;
+                    if (auth.completeLogin(pendingLoginUser, result, role)) {
+                        roleMatches = (pendingLoginAsAdmin && role == Authentication::Role::ADMIN) || (!pendingLoginAsAdmin && role == Authentication::Role::USER);
+                    }
+                    if (roleMatches) {
                         loginMessage = "Login successful!";
-                        loggedInUser = username;
+                        loggedInUser = pendingLoginUser;
+                        sessionToken = auth.startSession(loggedInUser);
                         roomManager.loadRooms(); // Ensure rooms are loaded after login
-                        currentState = isAdminLogin ? AppState::ADMIN_DASHBOARD : AppState::USER_DASHBOARD;
+                        dashboardView.invalidate();
+                        currentState = pendingLoginAsAdmin ? AppState::ADMIN_DASHBOARD : AppState::USER_DASHBOARD;
                     } else {
                         loginMessage = "Invalid credentials. Please try again.";
                     }
@@ -235,8 +377,17 @@ int main() {
 
                 // Register Button
                 GuiSetStyle(BUTTON, BASE_COLOR_NORMAL, ColorToInt(LIGHTGRAY)); // Give register a different color
-                if (GuiButton(Rectangle{ startX + buttonWidth + spacing, startY + 2 * (boxHeight + spacing) + 50, buttonWidth, buttonHeight }, "Register")) {
-                    if (auth.registerUser(username, password)) {
+                if (GuiButton(Rectangle{ startX + buttonWidth + spacing, startY + 2 * (boxHeight + spacing) + 50, buttonWidth, buttonHeight }, "Register") && !pendingRegister.valid()) {
+                    if (auth.hasUser(username)) {
+                        loginMessage = "Username already exists or invalid data.";
+                    } else {
+                        pendingRegister = auth.hashPasswordAsync(password, Authentication::Role::USER);
+                        pendingRegisterUser = username;
+                        loginMessage = "Registering...";
+                    }
+                }
+                if (pendingRegister.valid() && pendingRegister.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+                    if (auth.completeRegister(pendingRegisterUser, pendingRegister.get(), Authentication::Role::USER)) {
                         loginMessage = "Registration successful! Please login.";
                     } else {
                         loginMessage = "Username already exists or invalid data.";
@@ -256,17 +407,46 @@ int main() {
                 statusMessage = offlineManager.isOffline() ? "Status: OFFLINE" : "Status: ONLINE";
                 DrawText(statusMessage.c_str(), screenWidth - 250, 55, 18, offlineManager.isOffline() ? RED : GREEN);
 
+                Replicator::Stats replicationStats;
+                if (replicating) {
+                    replicationStats = replicator.getStats();
+                }
+                const DashboardView::Status& status = dashboardView.updateStatus(replicating ? &replicationStats : nullptr);
+                if (status.sync.visible) {
+                    IdleMode::keepAwake(); // Progress moves every frame
+                    DrawText(status.sync.text.c_str(), screenWidth - 520, 55, 18, ORANGE);
+                    if (GuiButton(Rectangle{ screenWidth - 390, 52, 60, 22 }, "Cancel")) {
+                        offlineManager.cancelSync();
+                    }
+                }
+                // Durability level and fsync latency, replication counters, offline queue depth
+                DrawText(status.durability.text.c_str(), 20, 48, 10, GRAY);
+                if (status.replication.visible) {
+                    DrawText(status.replication.text.c_str(), 20, 58, 10, GRAY);
+                }
+                if (status.queue.visible) {
+                    Color queueColor = status.queue.tone == DashboardView::Tone::ALERT ? RED :
+                        status.queue.tone == DashboardView::Tone::WARNING ? ORANGE : GRAY;
+                    DrawText(status.queue.text.c_str(), screenWidth - 520, 78, 10, queueColor);
+                }
+
 
                 // Common Dashboard UI
                 std::string welcome_text = "Welcome, " + loggedInUser + "!";
                 DrawText(welcome_text.c_str(), 20, 20, 20, DARKGRAY);
 
-                if (GuiButton(Rectangle{ (float)screenWidth - 120, 20, 100, 30 }, "Logout")) {
+                // O(1) token check; a revoked or expired session ends the dashboard
+                std::string sessionUser;
+                Authentication::Role sessionRole;
+                bool sessionValid = auth.validateSession(sessionToken, sessionUser, sessionRole);
+                if (GuiButton(Rectangle{ (float)screenWidth - 120, 20, 100, 30 }, "Logout") || !sessionValid) {
+                    auth.endSession(sessionToken);
+                    sessionToken = "";
                     loggedInUser = "";
                     // Clear credentials
                     memset(username, 0, 64);
                     memset(password, 0, 64);
-                    loginMessage = "";
+                    loginMessage = sessionValid ? "" : "Your session has ended. Please login again.";
                     isAdminLogin = false;
                     currentState = AppState::LOGIN;
                     // Reset popups
@@ -286,7 +466,7 @@ int main() {
                 // Toggle Online/Offline Button
                 if (GuiButton(Rectangle{ screenWidth - 400, 20, 140, 30 }, offlineManager.isOffline() ? "Go Online" : "Go Offline")) {
                     if (offlineManager.isOffline()) {
-                        offlineManager.goOnline();
+                        offlineManager.goOnlineInBackground();
                     } else {
                         offlineManager.goOffline();
                     }
@@ -306,6 +486,7 @@ int main() {
                         // Reset fields
                         memset(roomName, 0, 64);
                         memset(roomCapacity, 0, 10);
+                        addRoomMessage = "";
                     }
                     buttonY += 40;
                     if (GuiButton(Rectangle{ 20, (float)buttonY, sidebarWidth - 40, 30 }, "Modify Room")) {
@@ -319,6 +500,7 @@ int main() {
                     if (GuiButton(Rectangle{ 20, (float)buttonY, sidebarWidth - 40, 30 }, "Delete Room")) {
                         showDeleteRoomPopup = true;
                         memset(deleteRoomName, 0, 64);
+                        deleteRoomMessage = "";
                     }
                     // Add other admin buttons here: Modify Room, Add Admin etc.
                     buttonY += 40;
@@ -345,13 +527,20 @@ int main() {
                     buttonY += 40;
                     if (GuiButton(Rectangle{ 20, (float)buttonY, sidebarWidth - 40, 30 }, "View Users/Admins")) {
                         showViewUsersAdminsPopup = true;
-                        usersAdminsDisplayList.clear(); // Clear previous list
-                        // Populate list when popup opens
+                        usersAdminsPage = 0;
+                        usersAdminsNeedsFetch = true;
+                    }
+                    buttonY += 40;
+                    if (GuiButton(Rectangle{ 20, (float)buttonY, sidebarWidth - 40, 30 }, "Import Users")) {
+                        showImportUsersPopup = true;
+                        importUsersMessage = "";
+                        importUsersErrors.clear();
                     }
                     buttonY += 40;
                     if (GuiButton(Rectangle{ 20, (float)buttonY, sidebarWidth - 40, 30 }, "View Room History")) {
                         showRoomHistoryPopup = true;
-                        roomHistoryDisplayList.clear();
+                        roomHistoryPage = 0;
+                        roomHistoryNeedsFetch = true;
                     }
 
                 } else { // User Menu
@@ -372,6 +561,8 @@ int main() {
                     buttonY += 40;
                     if (GuiButton(Rectangle{ 20, (float)buttonY, sidebarWidth - 40, 30 }, "View Booking History")) {
                         showBookingHistoryPopup = true;
+                        bookingHistoryPage = 0;
+                        bookingHistoryNeedsFetch = true;
                     }
 
                 }
@@ -386,6 +577,8 @@ int main() {
                     buttonY += 40;
                     if (GuiButton(Rectangle{ 20, (float)buttonY, sidebarWidth - 40, 30 }, "View Booking History")) {
                         showBookingHistoryPopup = true;
+                        bookingHistoryPage = 0;
+                        bookingHistoryNeedsFetch = true;
                     }
                 }
                 // --- Main content area for rooms and filters ---
@@ -413,97 +606,51 @@ int main() {
                 }
                 contentAreaY += 60; // Increase vertical space to ensure rooms are drawn below all filters
 
-                // Filtered Rooms Logic
-                std::vector<Room> displayedRooms;
-                for (const auto& room : roomManager.getRooms()) {
-                    bool matchesSearch = true;
-                    if (strlen(searchRoomName) > 0) {
-                        std::string roomNameLower = room.getName();
-                        std::transform(roomNameLower.begin(), roomNameLower.end(), roomNameLower.begin(), ::tolower);
-                        std::string searchLower = searchRoomName;
-                        std::transform(searchLower.begin(), searchLower.end(), searchLower.begin(), ::tolower);
-                        if (roomNameLower.find(searchLower) == std::string::npos) {
-                            matchesSearch = false;
-                        }
-                    }
-
-                    bool matchesAvailability = true; // Default to true if no availability filter is active
-                    if (filterAvailableRooms && filterBookedRooms) {
-                        // If both are checked, it's a conflicting state, effectively no availability filter applied.
-                        // Or, you could make it show nothing, depending on desired UX.
-                        // For now, if both are checked, we'll show all rooms (i.e., this filter is ignored).
-                        matchesAvailability = true;
-                    } else if (filterAvailableRooms) {
-                        matchesAvailability = room.isAvailable();
-                    } else if (filterBookedRooms) {
-                        matchesAvailability = !room.isAvailable();
-                    } else {
-                        matchesAvailability = true; // Show all rooms by default if no specific availability filter is selected
-                    }
-
-                    bool matchesCapacity = true;
-                    if (strlen(filterCapacity) > 0) {
-                        try {
-                            int minCapacity = std::stoi(filterCapacity);
-                            if (room.getCapacity() < minCapacity) {
-                                matchesCapacity = false;
-                            }
-                        } catch (const std::exception& e) {
-                            // Handle invalid capacity input, perhaps display an error message
-                        }
-                    }
-
-                    if (matchesSearch && matchesAvailability && matchesCapacity) {
-                        displayedRooms.push_back(room);
-                    }
-                }
+                // Filtered Rooms Logic; while offline the queued changes are shown as if already synced
+                DashboardView::Filter roomFilter;
+                roomFilter.search = searchRoomName;
+                roomFilter.availableOnly = filterAvailableRooms;
+                roomFilter.bookedOnly = filterBookedRooms;
+                roomFilter.minCapacity = filterCapacity;
+                dashboardView.updateFloorPlan(roomFilter);
+                const std::vector<Room>& shownRooms = dashboardView.getShownRooms();
 
                 // --- Scrollable Floor Plan ---
                 Rectangle floorPlanView = { contentAreaX, contentAreaY, screenWidth - contentAreaX - 20, screenHeight - contentAreaY - 20 };
                 DrawRectangleLinesEx(floorPlanView, 1, Fade(DARKGRAY, 0.5f));
 
-                float roomBoxWidth = 180;
-                float roomBoxHeight = 100;
-                float padding = 20;
-                int roomsPerRow = (floorPlanView.width > 0) ? (int)(floorPlanView.width / (roomBoxWidth + padding)) : 1;
-                if (roomsPerRow == 0) roomsPerRow = 1;
-
-                int numRows = (displayedRooms.size() + roomsPerRow - 1) / roomsPerRow;
-                Rectangle floorPlanContent = { 0, 0, floorPlanView.width, (float)numRows * (roomBoxHeight + padding) };
+                DashboardView::Layout floorPlanLayout;
+                floorPlanLayout.x = floorPlanView.x;
+                floorPlanLayout.y = floorPlanView.y;
+                floorPlanLayout.width = floorPlanView.width;
+                floorPlanLayout.height = floorPlanView.height;
+                Rectangle floorPlanContent = { 0, 0, floorPlanView.width, dashboardView.getContentHeight(floorPlanLayout) };
 
                 Rectangle viewScroll = { 0 };
                 GuiScrollPanel(floorPlanView, NULL, floorPlanContent, &floorPlanScroll, &viewScroll);
 
-                BeginScissorMode(viewScroll.x, viewScroll.y, viewScroll.width, viewScroll.height);
-                {
-                    for (size_t i = 0; i < displayedRooms.size(); ++i) {
-                        int row = i / roomsPerRow;
-                        int col = i % roomsPerRow;
-
-                        float x = floorPlanView.x + col * (roomBoxWidth + padding) + floorPlanScroll.x;
-                        float y = floorPlanView.y + row * (roomBoxHeight + padding) + floorPlanScroll.y;
-
-                        Color roomColor = displayedRooms[i].isAvailable() ? Color{18, 160, 14, 255} : Color{190, 30, 45, 255};
-                        DrawRectangle(x, y, roomBoxWidth, roomBoxHeight, roomColor);
-                        DrawRectangleLines(x, y, roomBoxWidth, roomBoxHeight, DARKBROWN);
+                // Only the rows inside the viewport are laid out, so the cost does not grow with the room count
+                floorPlanLayout.scrollX = floorPlanScroll.x;
+                floorPlanLayout.scrollY = floorPlanScroll.y;
+                const std::vector<DashboardView::Tile>& visibleTiles = dashboardView.layoutTiles(floorPlanLayout);
 
-                        DrawText(displayedRooms[i].getName().c_str(), x + 10, y + 10, 20, WHITE);
-                        std::string capacityStr = "Capacity: " + std::to_string(displayedRooms[i].getCapacity());
-                        DrawText(capacityStr.c_str(), x + 10, y + 35, 15, WHITE);
+                // Tiles whose room changed are rendered into the atlas first, outside the scissor
+                roomTiles.beginFrame();
+                for (const auto& tile : visibleTiles) {
+                    roomTiles.prepare(*tile.room);
+                }
 
-                        if (!displayedRooms[i].isAvailable()) {
-                            std::string bookedByStr = "Booked: " + displayedRooms[i].getBookedBy();
-                            DrawText(bookedByStr.c_str(), x + 10, y + 60, 15, YELLOW);
-                        } else {
-                            DrawText("Available", x + 10, y + 60, 15, WHITE);
-                        }
+                BeginScissorMode(viewScroll.x, viewScroll.y, viewScroll.width, viewScroll.height);
+                {
+                    for (const auto& tile : visibleTiles) {
+                        roomTiles.draw(*tile.room, tile.x, tile.y);
                     }
                 }
                 EndScissorMode();
 
-                if (displayedRooms.empty() && !roomManager.getRooms().empty()) {
+                if (dashboardView.getMatchCount() == 0 && !shownRooms.empty()) {
                     DrawText("No rooms match your search/filters.", contentAreaX + 20, contentAreaY + 20, 20, GRAY);
-                } else if (roomManager.getRooms().empty()) {
+                } else if (shownRooms.empty()) {
                     DrawText("No rooms created yet. Admin needs to add rooms.", contentAreaX + 20, contentAreaY + 20, 20, GRAY);
                 }
 
@@ -533,17 +680,22 @@ int main() {
                 try {
                     int capacity = std::stoi(roomCapacity);
                     if (offlineManager.isOffline()) {
-                        offlineManager.queueUploadRoom(loggedInUser, roomName, capacity, true);
+                        if (offlineManager.queueUploadRoom(loggedInUser, roomName, capacity, true)) {
+                            showAddRoomPopup = false;
+                        } else {
+                            addRoomMessage = "Offline queue is full. Room not queued.";
+                        }
                     } else {
                         roomManager.addRoom(loggedInUser, roomName, capacity, true); // Add room as available by default
                         roomManager.saveRooms(); // Persist change
+                        showAddRoomPopup = false;
                     }
-                    showAddRoomPopup = false;
                 } catch (const std::exception& e) {
                     // Handle invalid number format for capacity
                     std::cerr << "Invalid capacity input: " << e.what() << std::endl;
                 }
             }
+            DrawText(addRoomMessage.c_str(), popupRect.x + 20, popupRect.y + 200, 20, MAROON);
         }
 
         if (showBookRoomPopup) {
@@ -571,8 +723,11 @@ int main() {
                     int capacity = std::stoi(bookCapacity);
                     std::string roomToBook = std::string(bookRoomName);
                     if (offlineManager.isOffline()) {
-                        offlineManager.queueBookRoom(loggedInUser, capacity, roomToBook);
-                        bookingMessage = "Booking queued for room: " + (roomToBook.empty() ? "any suitable" : roomToBook);
+                        if (offlineManager.queueBookRoom(loggedInUser, capacity, roomToBook)) {
+                            bookingMessage = "Booking queued for room: " + (roomToBook.empty() ? "any suitable" : roomToBook);
+                        } else {
+                            bookingMessage = "Offline queue is full. Booking not queued.";
+                        }
                     } else {
                         Room* bookedRoom = bookingSystem.bookRoom(loggedInUser, capacity, roomToBook);
                         if (bookedRoom) {
@@ -605,8 +760,11 @@ int main() {
 
             if (GuiButton(Rectangle{ popupRect.x + popupWidth/2 - 50, popupRect.y + 140, 100, 40 }, "Release")) {
                 if (offlineManager.isOffline()) {
-                    offlineManager.queueReleaseRoom(loggedInUser, releaseRoomName);
-                    releaseRoomMessage = "Room release has been queued due to being offline.";
+                    if (offlineManager.queueReleaseRoom(loggedInUser, releaseRoomName)) {
+                        releaseRoomMessage = "Room release has been queued due to being offline.";
+                    } else {
+                        releaseRoomMessage = "Offline queue is full. Release not queued.";
+                    }
                 } else {
                     ReleaseRoomStatus status = bookingSystem.releaseRoom(loggedInUser, releaseRoomName, true);
                     switch (status) {
@@ -651,7 +809,7 @@ int main() {
             }
 
             if (GuiButton(Rectangle{ popupRect.x + 130, popupRect.y + 90, 100, 30 }, "Load Details")) {
-                Room* room = roomManager.findRoom(modifyRoomName);
+                const Room* room = offlineManager.isOffline() ? offlineManager.findProjectedRoom(modifyRoomName) : roomManager.findRoom(modifyRoomName);
                 if (room) {
                     snprintf(modifyRoomCapacity, 10, "%d", room->getCapacity());
                     modifyRoomAvailability = room->isAvailable();
@@ -676,8 +834,11 @@ int main() {
                 try {
                     int capacity = std::stoi(modifyRoomCapacity);
                     if (offlineManager.isOffline()) {
-                        offlineManager.queueModifyRoom(loggedInUser, modifyRoomName, capacity, modifyRoomAvailability);
-                        modifyRoomMessage = "Modification queued.";
+                        if (offlineManager.queueModifyRoom(loggedInUser, modifyRoomName, capacity, modifyRoomAvailability)) {
+                            modifyRoomMessage = "Modification queued.";
+                        } else {
+                            modifyRoomMessage = "Offline queue is full. Modification not queued.";
+                        }
                     } else {
                         roomManager.modifyRoom(loggedInUser, modifyRoomName, capacity, modifyRoomAvailability);
                         roomManager.saveRooms();
@@ -705,7 +866,7 @@ int main() {
             }
 
             if (GuiButton(Rectangle{ popupRect.x + popupWidth/2 - 50, popupRect.y + 150, 100, 40 }, "Delete")) {
-                Room* room = roomManager.findRoom(deleteRoomName);
+                const Room* room = offlineManager.isOffline() ? offlineManager.findProjectedRoom(deleteRoomName) : roomManager.findRoom(deleteRoomName);
                 if (room) {
                     // Check if room is booked before deleting
                     if (!room->isAvailable()) {
@@ -714,18 +875,23 @@ int main() {
                         DrawText("Cannot delete booked room!", popupRect.x + 20, popupRect.y + 200, 20, RED);
                     } else {
                         if (offlineManager.isOffline()) {                            
-                            offlineManager.queueDeleteRoom(deleteRoomName, loggedInUser);
-                            DrawText("Deletion queued.", popupRect.x + 20, popupRect.y + 200, 20, LIME);
+                            if (offlineManager.queueDeleteRoom(deleteRoomName, loggedInUser)) {
+                                DrawText("Deletion queued.", popupRect.x + 20, popupRect.y + 200, 20, LIME);
+                                showDeleteRoomPopup = false;
+                            } else {
+                                deleteRoomMessage = "Offline queue is full. Deletion not queued.";
+                            }
                         } else {
                             roomManager.deleteRoom(deleteRoomName, loggedInUser);
                             DrawText("Room deleted successfully.", popupRect.x + 20, popupRect.y + 200, 20, LIME);
+                            showDeleteRoomPopup = false;
                         }
-                        showDeleteRoomPopup = false;
                     }
                 } else {
                     DrawText("Room not found!", popupRect.x + 20, popupRect.y + 200, 20, RED);
                 }
             }
+            DrawText(deleteRoomMessage.c_str(), popupRect.x + 20, popupRect.y + 200, 20, MAROON);
             // If the popup is still open after trying to delete a booked room, the message will persist.
             // A more robust solution would use a dedicated message variable for this popup.
             if (showDeleteRoomPopup) {
@@ -755,16 +921,20 @@ int main() {
                 newAdminPasswordEditMode = !newAdminPasswordEditMode;
             }
 
-            if (GuiButton(Rectangle{ popupRect.x + popupWidth/2 - 50, popupRect.y + 150, 100, 40 }, "Register")) {
+            if (GuiButton(Rectangle{ popupRect.x + popupWidth/2 - 50, popupRect.y + 150, 100, 40 }, "Register") && !pendingAddAdmin.valid()) {
                 if (offlineManager.isOffline()) {
-                    offlineManager.queueRegisterNewAdmin(loggedInUser, newAdminUsername, newAdminPassword);
-                    addAdminMessage = "Admin registration queued.";
-                } else {
-                    if (auth.registerAdmin(newAdminUsername, newAdminPassword)) {
-                        addAdminMessage = "Admin registered successfully!";
+                    if (offlineManager.queueRegisterNewAdmin(loggedInUser, newAdminUsername, newAdminPassword)) {
+                        addAdminMessage = "Admin registration queued.";
                     } else {
-                        addAdminMessage = "Admin registration failed (username exists).";
+                        addAdminMessage = "Offline queue is full. Registration not queued.";
                     }
+                } else if (auth.hasUser(newAdminUsername)) {
+                    addAdminMessage = "Admin registration failed (username exists).";
+                } else {
+                    pendingAddAdmin = auth.hashPasswordAsync(newAdminPassword, Authentication::Role::ADMIN);
+                    pendingAddAdminUser = newAdminUsername;
+                    pendingAddAdminPassword = newAdminPassword;
+                    addAdminMessage = "Registering...";
                 }
             }
             DrawText(addAdminMessage.c_str(), popupRect.x + 20, popupRect.y + 210, 20, MAROON);
@@ -787,8 +957,11 @@ int main() {
                     deleteUserAdminMessage = "Cannot delete superadmin 'Chetan'.";
                 } else {
                     if (offlineManager.isOffline()) {
-                        offlineManager.queueDeleteUser(deleteTargetUsername);
-                        deleteUserAdminMessage = "Deletion queued.";
+                        if (offlineManager.queueDeleteUser(deleteTargetUsername)) {
+                            deleteUserAdminMessage = "Deletion queued.";
+                        } else {
+                            deleteUserAdminMessage = "Offline queue is full. Deletion not queued.";
+                        }
                     } else {
                         if (auth.deleteUser(deleteTargetUsername)) {
                             deleteUserAdminMessage = "User/Admin deleted successfully.";
@@ -814,19 +987,14 @@ int main() {
             }
 
             if (GuiButton(Rectangle{ popupRect.x + 130, popupRect.y + 90, 100, 30 }, "Load Details")) {
-                // Find user/admin to pre-fill details
-                std::vector<std::pair<std::string, Authentication::Role>> users = auth.getUsersAndAdmins();
-                bool found = false;
-                for (const auto& userPair : users) {
-                    if (userPair.first == std::string(editTargetUsername)) {
-                        // For simplicity, we don't load password, just role
-                        editNewRoleActive = (userPair.second == Authentication::Role::ADMIN) ? 1 : 0;
-                        editUserAdminMessage = "Details loaded.";
-                        found = true;
-                        break;
-                    }
-                }
-                if (!found) {
+                // Find user/admin to pre-fill details; we don't load the password, just the role
+                Authentication::Role role;
+                bool found = offlineManager.isOffline() ? offlineManager.findProjectedUser(editTargetUsername, role)
+                                                        : auth.getUserRole(editTargetUsername, role);
+                if (found) {
+                    editNewRoleActive = (role == Authentication::Role::ADMIN) ? 1 : 0;
+                    editUserAdminMessage = "Details loaded.";
+                } else {
                     editUserAdminMessage = "User/Admin not found.";
                     editNewRoleActive = 0;
                 }
@@ -843,20 +1011,25 @@ int main() {
             GuiLabel(Rectangle{ popupRect.x + 20, popupRect.y + 190, 100, 20 }, "New Role:");
             GuiDropdownBox(Rectangle{ popupRect.x + 130, popupRect.y + 180, 150, 40 }, "USER;ADMIN", &editNewRoleActive, true);
 
-            if (GuiButton(Rectangle{ popupRect.x + popupWidth/2 - 70, popupRect.y + 240, 140, 40 }, "Save Changes")) {
+            if (GuiButton(Rectangle{ popupRect.x + popupWidth/2 - 70, popupRect.y + 240, 140, 40 }, "Save Changes") && !pendingEdit.valid()) {
                 if (std::string(editTargetUsername) == "Chetan") {
                     editUserAdminMessage = "Cannot edit superadmin 'Chetan'.";
                 } else {
                     Authentication::Role newRole = (editNewRoleActive == 1) ? Authentication::Role::ADMIN : Authentication::Role::USER;
                     if (offlineManager.isOffline()) {
-                        offlineManager.queueEditUser(editTargetUsername, editNewPassword, newRole);
-                        editUserAdminMessage = "Modification queued.";
-                    } else {
-                        if (auth.editUser(editTargetUsername, editNewPassword, newRole)) {
-                            editUserAdminMessage = "User/Admin modified successfully.";
+                        if (offlineManager.queueEditUser(editTargetUsername, editNewPassword, newRole)) {
+                            editUserAdminMessage = "Modification queued.";
                         } else {
-                            editUserAdminMessage = "User/Admin not found.";
+                            editUserAdminMessage = "Offline queue is full. Modification not queued.";
                         }
+                    } else if (!auth.hasUser(editTargetUsername)) {
+                        editUserAdminMessage = "User/Admin not found.";
+                    } else {
+                        pendingEdit = auth.hashPasswordAsync(editNewPassword, newRole);
+                        pendingEditUser = editTargetUsername;
+                        pendingEditPassword = editNewPassword;
+                        pendingEditRole = newRole;
+                        editUserAdminMessage = "Saving...";
                     }
                 }
             }
@@ -870,33 +1043,99 @@ int main() {
             
             showViewUsersAdminsPopup = !GuiWindowBox(popupRect, "Users and Admins");
 
-            float maxTextWidth = 0;
-            if (usersAdminsDisplayList.empty()) { // Populate list only once when opened
-                std::vector<std::pair<std::string, Authentication::Role>> users = auth.getUsersAndAdmins();
-                for (const auto& userPair : users) {
-                    std::string line = userPair.first + " (" + (userPair.second == Authentication::Role::ADMIN ? "Admin" : "User") + ")";
-                    usersAdminsDisplayList.push_back(line);
-                    float currentWidth = MeasureText(line.c_str(), 15);
-                    if (currentWidth > maxTextWidth) {
-                        maxTextWidth = currentWidth;
-                    }
+            if (GuiTextBox(Rectangle{ popupRect.x + 10, popupRect.y + 35, popupRect.width * 0.5f, 30 }, usersAdminsSearch, 64, usersAdminsSearchEditMode)) {
+                usersAdminsSearchEditMode = !usersAdminsSearchEditMode;
+            }
+            GuiToggleGroup(Rectangle{ popupRect.x + popupRect.width * 0.5f + 20, popupRect.y + 35, (popupRect.width * 0.5f - 40) / 3, 30 }, "All;Users;Admins", &usersAdminsRoleFilter);
+
+            Rectangle view = { popupRect.x + 10, popupRect.y + 75, popupRect.width - 20, popupRect.height - 135 };
+            std::size_t usersAdminsPageSize = std::max(1, (int)((view.height - 20) / 25)); // Rows that fit without scrolling
+            int roleFilter = usersAdminsRoleFilter == 1 ? (int)Authentication::Role::USER
+                           : usersAdminsRoleFilter == 2 ? (int)Authentication::Role::ADMIN
+                           : UserDirectory::ANY_ROLE;
+
+            // Refetch only when the search, filter, page size or the directory itself changed
+            if (usersAdminsFetchedSearch != usersAdminsSearch || usersAdminsFetchedRole != roleFilter) {
+                usersAdminsPage = 0;
+                usersAdminsNeedsFetch = true;
+            }
+            if (usersAdminsFetchedPageSize != usersAdminsPageSize || usersAdminsFetchedVersion != auth.getDirectoryVersion()) {
+                usersAdminsNeedsFetch = true;
+            }
+            if (usersAdminsNeedsFetch) {
+                UserDirectory::Page page = auth.queryUsers(usersAdminsSearch, roleFilter, usersAdminsPage * usersAdminsPageSize, usersAdminsPageSize);
+                if (page.empty() && usersAdminsPage > 0 && page.totalMatches > 0) {
+                    // Users were removed from under the current page; show the last one instead
+                    usersAdminsPage = (page.totalMatches - 1) / usersAdminsPageSize;
+                    page = auth.queryUsers(usersAdminsSearch, roleFilter, usersAdminsPage * usersAdminsPageSize, usersAdminsPageSize);
+                }
+                usersAdminsTotal = page.totalMatches;
+                usersAdminsList.clear();
+                for (const auto& entry : page) {
+                    usersAdminsList.append(DashboardView::formatAccount(entry));
                 }
+                usersAdminsFetchedSearch = usersAdminsSearch;
+                usersAdminsFetchedRole = roleFilter;
+                usersAdminsFetchedPageSize = usersAdminsPageSize;
+                usersAdminsFetchedVersion = auth.getDirectoryVersion();
+                usersAdminsNeedsFetch = false;
+            }
+
+            usersAdminsList.draw(view);
+
+            // Pagination controls
+            std::size_t usersAdminsPageCount = (usersAdminsTotal + usersAdminsPageSize - 1) / usersAdminsPageSize;
+            float controlsY = popupRect.y + popupRect.height - 50;
+            if (usersAdminsPage > 0 && GuiButton(Rectangle{ popupRect.x + 10, controlsY, 100, 30 }, "< Prev")) {
+                usersAdminsPage--;
+                usersAdminsNeedsFetch = true;
             }
+            if (usersAdminsPage + 1 < usersAdminsPageCount && GuiButton(Rectangle{ popupRect.x + popupRect.width - 110, controlsY, 100, 30 }, "Next >")) {
+                usersAdminsPage++;
+                usersAdminsNeedsFetch = true;
+            }
+            std::string usersAdminsPageText = DashboardView::formatPageText(usersAdminsPage, usersAdminsPageCount, usersAdminsTotal, "accounts");
+            DrawText(usersAdminsPageText.c_str(), popupRect.x + popupRect.width / 2 - MeasureText(usersAdminsPageText.c_str(), 15) / 2, controlsY + 8, 15, DARKGRAY);
+        }
 
-            Rectangle view = { popupRect.x + 10, popupRect.y + 40, popupRect.width - 20, popupRect.height - 60 };
-            float contentWidth = (maxTextWidth > view.width) ? maxTextWidth + 20 : view.width;
-            Rectangle content = { 0, 0, contentWidth, (float)usersAdminsDisplayList.size() * 25 };
+        if (showImportUsersPopup) {
+            float popupWidth = screenWidth * 0.45f;
+            float popupHeight = screenHeight * 0.5f;
+            Rectangle popupRect = { (float)screenWidth/2 - popupWidth/2, (float)screenHeight/2 - popupHeight/2, (float)popupWidth, (float)popupHeight };
 
-            Rectangle viewScroll = { 0 };
-            GuiScrollPanel(view, NULL, content, &usersAdminsScroll, &viewScroll);
+            showImportUsersPopup = !GuiWindowBox(popupRect, "Import Users (CSV/TSV: username,password[,role])");
 
-            BeginScissorMode(viewScroll.x, viewScroll.y, viewScroll.width, viewScroll.height);
-            {
-                for(size_t i = 0; i < usersAdminsDisplayList.size(); ++i) {
-                    DrawText(usersAdminsDisplayList[i].c_str(), view.x + 10 + usersAdminsScroll.x, view.y + 10 + i * 25 + usersAdminsScroll.y, 15, DARKGRAY);
+            GuiLabel(Rectangle{ popupRect.x + 20, popupRect.y + 50, 100, 20 }, "File path:");
+            if (GuiTextBox(Rectangle{ popupRect.x + 120, popupRect.y + 40, popupWidth - 140, 40 }, importUsersPath, 256, importUsersPathEditMode)) {
+                importUsersPathEditMode = !importUsersPathEditMode;
+            }
+
+            if (GuiButton(Rectangle{ popupRect.x + popupWidth/2 - 50, popupRect.y + 95, 100, 40 }, "Import") && !pendingImport.valid()) {
+                importUsersErrors.clear();
+                if (offlineManager.isOffline()) {
+                    importUsersMessage = "Import is unavailable while offline.";
+                } else {
+                    pendingImport = auth.importUsersAsync(importUsersPath, &importProgress);
                 }
             }
-            EndScissorMode();
+            if (pendingImport.valid()) {
+                importUsersMessage = "Importing... " + std::to_string(importProgress.rowsRead.load()) + " rows read, " +
+                                     std::to_string(importProgress.hashed.load()) + " of " + std::to_string(importProgress.accepted.load()) + " hashed";
+            }
+            DrawText(importUsersMessage.c_str(), popupRect.x + 20, popupRect.y + 150, 20, MAROON);
+
+            // Only as many errors as fit; the total is always shown
+            int errorY = popupRect.y + 180;
+            std::size_t shownErrors = 0;
+            while (shownErrors < importUsersErrors.size() && errorY + 18 < popupRect.y + popupRect.height - 25) {
+                DrawText(importUsersErrors[shownErrors].c_str(), popupRect.x + 20, errorY, 15, DARKGRAY);
+                errorY += 18;
+                shownErrors++;
+            }
+            if (shownErrors < importUsersErrors.size()) {
+                DrawText(("... and " + std::to_string(importUsersErrors.size() - shownErrors) + " more rejected rows").c_str(),
+                         popupRect.x + 20, errorY, 15, DARKGRAY);
+            }
         }
 
         if (showOfflineQueuePopup) {
@@ -906,31 +1145,14 @@ int main() {
             
             showOfflineQueuePopup = !GuiWindowBox(popupRect, "Offline Action Queue");
 
-            std::vector<std::string> queue = offlineManager.getQueueForDisplay();
+            const std::vector<std::string>& queue = offlineManager.getQueueForDisplay();
 
             if (queue.empty()) {
                 DrawText("Offline queue is empty.", popupRect.x + 20, popupRect.y + 50, 20, GRAY);
             } else {
-                float maxTextWidth = 0;
-                for(const auto& line : queue) {
-                    float currentWidth = MeasureText(line.c_str(), 15);
-                    if (currentWidth > maxTextWidth) maxTextWidth = currentWidth;
-                }
-
-                Rectangle view = { popupRect.x + 10, popupRect.y + 40, popupRect.width - 20, popupRect.height - 60 };
-                float contentWidth = (maxTextWidth > view.width) ? maxTextWidth + 20 : view.width;
-                Rectangle content = { 0, 0, contentWidth, (float)queue.size() * 25 };
-                Rectangle viewScroll = { 0 };
-                
-                GuiScrollPanel(view, NULL, content, &scroll, &viewScroll);
-
-                BeginScissorMode(viewScroll.x, viewScroll.y, viewScroll.width, viewScroll.height);
-                {
-                    for(size_t i = 0; i < queue.size(); ++i) {
-                        DrawText(queue[i].c_str(), view.x + 10 + scroll.x, view.y + 10 + i * 25 + scroll.y, 15, DARKGRAY);
-                    }
-                }
-                EndScissorMode();
+                // Only actions queued since the last frame are measured
+                offlineQueueList.sync(queue, offlineManager.getQueueVersion());
+                offlineQueueList.draw(Rectangle{ popupRect.x + 10, popupRect.y + 40, popupRect.width - 20, popupRect.height - 60 });
             }
         }
 
@@ -941,42 +1163,35 @@ int main() {
             
             showRoomHistoryPopup = !GuiWindowBox(popupRect, "Room Modification History");
 
-            float maxTextWidth = 0;
-            // Recalculate history list and max width if it's empty
-            if (roomHistoryDisplayList.empty()) {
-                auto history = roomHistoryManager.getAllHistory();
-                for (const auto& entry : history) {
-                    char buffer[200];
-                    struct tm * timeinfo;
-                    timeinfo = localtime(&entry.timestamp);
-                    strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", timeinfo);
-                    std::string line = std::string(buffer) + " | Room: " + entry.roomName + " | Action: " + entry.action + " | By: " + entry.adminName;
-                    if (entry.action != "DELETE") {
-                        line += " | Capacity: " + std::to_string(entry.capacity) + " | Available: " + (entry.isAvailable ? "Yes" : "No");
-                    }
-                    roomHistoryDisplayList.push_back(line);
+            // Only the displayed page is fetched, and only when the page changes
+            if (roomHistoryNeedsFetch) {
+                HistoryQuery query;
+                query.offset = roomHistoryPage * historyPageSize;
+                query.limit = historyPageSize;
+                auto history = roomHistoryManager.queryHistory(query);
+                roomHistoryTotal = history.totalMatches;
+                roomHistoryList.clear();
+                for (const auto& entry : history.entries) {
+                    roomHistoryList.append(DashboardView::formatRoomHistory(entry));
                 }
+                roomHistoryNeedsFetch = false;
             }
 
-            // Always calculate max width from the existing list to ensure scrolling works
-            for (const auto& line : roomHistoryDisplayList) {
-                maxTextWidth = fmaxf(maxTextWidth, MeasureText(line.c_str(), 15));
-            }
+            roomHistoryList.draw(Rectangle{ popupRect.x + 10, popupRect.y + 40, popupRect.width - 20, popupRect.height - 100 });
 
-            Rectangle view = { popupRect.x + 10, popupRect.y + 40, popupRect.width - 20, popupRect.height - 60 };
-            float contentWidth = (maxTextWidth > view.width) ? maxTextWidth + 20 : view.width;
-            Rectangle content = { 0, 0, contentWidth, (float)roomHistoryDisplayList.size() * 25 };
-            Rectangle viewScroll = { 0 };
-            
-            GuiScrollPanel(view, NULL, content, &roomHistoryScroll, &viewScroll);
-
-            BeginScissorMode(viewScroll.x, viewScroll.y, viewScroll.width, viewScroll.height);
-            {
-                for(size_t i = 0; i < roomHistoryDisplayList.size(); ++i) {
-                    DrawText(roomHistoryDisplayList[i].c_str(), view.x + 10 + roomHistoryScroll.x, view.y + 10 + i * 25 + roomHistoryScroll.y, 15, DARKGRAY);
-                }
+            // Pagination controls
+            std::size_t roomHistoryPageCount = (roomHistoryTotal + historyPageSize - 1) / historyPageSize;
+            float controlsY = popupRect.y + popupRect.height - 50;
+            if (roomHistoryPage > 0 && GuiButton(Rectangle{ popupRect.x + 10, controlsY, 100, 30 }, "< Prev")) {
+                roomHistoryPage--;
+                roomHistoryNeedsFetch = true;
+            }
+            if (roomHistoryPage + 1 < roomHistoryPageCount && GuiButton(Rectangle{ popupRect.x + popupRect.width - 110, controlsY, 100, 30 }, "Next >")) {
+                roomHistoryPage++;
+                roomHistoryNeedsFetch = true;
             }
-            EndScissorMode();
+            std::string roomHistoryPageText = DashboardView::formatPageText(roomHistoryPage, roomHistoryPageCount, roomHistoryTotal, "entries");
+            DrawText(roomHistoryPageText.c_str(), popupRect.x + popupRect.width / 2 - MeasureText(roomHistoryPageText.c_str(), 15) / 2, controlsY + 8, 15, DARKGRAY);
         }
 
         if (showBookingHistoryPopup) {
@@ -986,43 +1201,49 @@ int main() {
             
             showBookingHistoryPopup = !GuiWindowBox(popupRect, "Booking History");
 
-            std::vector<std::string> bookingHistoryDisplayList;
-            float maxTextWidth = 0;
-            auto history = bookingHistoryManager.getAllHistory();
-            for (const auto& entry : history) {
-                if (currentState == AppState::USER_DASHBOARD && entry.username != loggedInUser) {
-                    continue; // Users only see their own history
+            if (bookingHistoryNeedsFetch) {
+                HistoryQuery query;
+                if (currentState == AppState::USER_DASHBOARD) {
+                    query.filter.username = loggedInUser; // Users only see their own history
                 }
-                char buffer[200];
-                struct tm * timeinfo;
-                timeinfo = localtime(&entry.timestamp);
-                strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", timeinfo);
-                std::string line = std::string(buffer) + " | Room: " + entry.roomName + " | User: " + entry.username + " | Action: " + entry.action;
-                float currentWidth = MeasureText(line.c_str(), 15);
-                if (currentWidth > maxTextWidth) maxTextWidth = currentWidth;
-                bookingHistoryDisplayList.push_back(line);
+                query.offset = bookingHistoryPage * historyPageSize;
+                query.limit = historyPageSize;
+                auto history = bookingHistoryManager.queryHistory(query);
+                bookingHistoryTotal = history.totalMatches;
+                bookingHistoryList.clear();
+                for (const auto& entry : history.entries) {
+                    bookingHistoryList.append(DashboardView::formatBookingHistory(entry));
+                }
+                bookingHistoryNeedsFetch = false;
             }
 
-            Rectangle view = { popupRect.x + 10, popupRect.y + 40, popupRect.width - 20, popupRect.height - 60 };
-            float contentWidth = (maxTextWidth > view.width) ? maxTextWidth + 20 : view.width;
-            Rectangle content = { 0, 0, contentWidth, (float)bookingHistoryDisplayList.size() * 25 };
-            Rectangle viewScroll = { 0 };
-            GuiScrollPanel(view, NULL, content, &bookingHistoryScroll, &viewScroll);
-            BeginScissorMode(viewScroll.x, viewScroll.y, viewScroll.width, viewScroll.height);
-            {
-                for(size_t i = 0; i < bookingHistoryDisplayList.size(); ++i) {
-                    DrawText(bookingHistoryDisplayList[i].c_str(), view.x + 10 + bookingHistoryScroll.x, view.y + 10 + i * 25 + bookingHistoryScroll.y, 15, DARKGRAY);
-                }
+            bookingHistoryList.draw(Rectangle{ popupRect.x + 10, popupRect.y + 40, popupRect.width - 20, popupRect.height - 100 });
+
+            // Pagination controls
+            std::size_t bookingHistoryPageCount = (bookingHistoryTotal + historyPageSize - 1) / historyPageSize;
+            float controlsY = popupRect.y + popupRect.height - 50;
+            if (bookingHistoryPage > 0 && GuiButton(Rectangle{ popupRect.x + 10, controlsY, 100, 30 }, "< Prev")) {
+                bookingHistoryPage--;
+                bookingHistoryNeedsFetch = true;
+            }
+            if (bookingHistoryPage + 1 < bookingHistoryPageCount && GuiButton(Rectangle{ popupRect.x + popupRect.width - 110, controlsY, 100, 30 }, "Next >")) {
+                bookingHistoryPage++;
+                bookingHistoryNeedsFetch = true;
             }
-            EndScissorMode();
+            std::string bookingHistoryPageText = DashboardView::formatPageText(bookingHistoryPage, bookingHistoryPageCount, bookingHistoryTotal, "entries");
+            DrawText(bookingHistoryPageText.c_str(), popupRect.x + popupRect.width / 2 - MeasureText(bookingHistoryPageText.c_str(), 15) / 2, controlsY + 8, 15, DARKGRAY);
         }
 
+        IdleMode::endFrame();
+        stateLock.unlock(); // The sync worker runs while EndDrawing() waits for the frame
         EndDrawing();
         //----------------------------------------------------------------------------------
     }
 
     // De-Initialization
     //--------------------------------------------------------------------------------------
+    IdleMode::shutdown();
+    roomTiles.unload();
     CloseWindow();        // Close window and OpenGL context
     //--------------------------------------------------------------------------------------
 
@@ -2,7 +2,16 @@
 #ifndef AUTH_HPP
 #define AUTH_HPP
 
+#include "threadpool.hpp"
+#include "credentialstore.hpp"
+#include "session.hpp"
+#include "userdirectory.hpp"
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 
@@ -13,23 +22,151 @@ public:
         ADMIN
     };
 
+    struct Credential {
+        std::string passwordHash; // PasswordHasher record, carries its own cost
+        Role role;
+        std::uint64_t version = 0; // Stamp of the last register/edit, never reused for the account
+    };
+
+    struct LoginResult {
+        bool success = false;
+        Role role = Role::USER;
+        std::string verifiedHash; // Record the password was checked against
+        std::string upgradedHash; // Set when the stored hash should be replaced (legacy or low cost)
+    };
+
+    struct ImportRowError {
+        std::size_t line;
+        std::string message;
+    };
+
+    struct ImportReport {
+        std::size_t rowsRead = 0;
+        std::size_t imported = 0;
+        std::vector<ImportRowError> errors;
+        double parseMs = 0;
+        double hashMs = 0;
+        double persistMs = 0;
+        double totalMs = 0;
+        double rowsPerSecond() const { return totalMs > 0 ? imported * 1000.0 / totalMs : 0; }
+    };
+
+    // Advanced by importUsersAsync() while it runs, so the caller can show how far it got
+    struct ImportProgress {
+        std::atomic<std::size_t> rowsRead{0};
+        std::atomic<std::size_t> accepted{0}; // Rows that passed validation and need hashing
+        std::atomic<std::size_t> hashed{0};
+    };
+
+    // Rows read and hashed by importUsersAsync(), waiting for completeImport()
+    struct PreparedImport {
+        struct Row {
+            std::size_t line;
+            std::string username;
+            std::string password; // Cleared once hashed
+            Role role;
+            std::string passwordHash;
+        };
+        bool opened = false;
+        ImportReport report;
+        std::vector<Row> rows;
+        std::chrono::steady_clock::time_point started;
+    };
+
     Authentication();
+    ~Authentication();
     bool registerUser(const std::string& username, const std::string& password);
     bool registerAdmin(const std::string& username, const std::string& password);
     bool loginUser(const std::string& username, const std::string& password, Role& role);
     bool login(const std::string& username, const std::string& password, bool isAdmin);
     bool deleteUser(const std::string& usernameToDelete);
     bool editUser(const std::string& usernameToEdit, const std::string& newPassword, Role newRole);
+    bool hasUser(const std::string& username) const;
+    // Both are single-stripe lookups; the version is 0 when the account does not exist
+    std::uint64_t getUserVersion(const std::string& username) const;
+    bool getUserRole(const std::string& username, Role& role) const;
     std::vector<std::pair<std::string, Role>> getUsersAndAdmins() const;
+    // Sorted, prefix-searchable view of the accounts; role is a Role value or UserDirectory::ANY_ROLE.
+    // The page points into the directory, so it is only for the thread that also performs mutations.
+    UserDirectory::Page queryUsers(const std::string& prefix, int role, std::size_t offset, std::size_t limit) const;
+    std::uint64_t getDirectoryVersion() const;
+
+    // Bulk provisioning from a CSV or TSV file with rows "username,password[,role]".
+    // Passwords are hashed in parallel and all accepted rows are persisted with one
+    // journal write. Rejected rows are listed in the report and do not stop the import.
+    bool importUsers(const std::string& path, ImportReport& report);
+    // The same import with the file reading and hashing on a worker thread; completeImport()
+    // then stores the accounts on the calling thread, like completeLogin(). progress may be
+    // null and must outlive the future.
+    std::future<PreparedImport> importUsersAsync(const std::string& path, ImportProgress* progress);
+    bool completeImport(PreparedImport& prepared, ImportReport& report);
+
+    // Runs the password KDF on the verification pool so the caller (GUI thread) never blocks.
+    // Call completeLogin() with the result to apply hash upgrades.
+    std::future<LoginResult> loginUserAsync(const std::string& username, const std::string& password);
+    bool completeLogin(const std::string& username, const LoginResult& result, Role& role);
+    // Registrations and edits hash on the same pool; completeRegister() and
+    // completeEditUser() then store the record, with the checks and messages of
+    // registerUser()/registerAdmin() and editUser().
+    std::future<std::string> hashPasswordAsync(const std::string& password, Role role);
+    bool completeRegister(const std::string& username, const std::string& passwordHash, Role role);
+    bool completeEditUser(const std::string& usernameToEdit, const std::string& passwordHash, Role newRole);
+
+    // Sessions let callers skip re-verifying the password after the initial login.
+    // deleteUser() and editUser() revoke every session of the affected account.
+    std::string startSession(const std::string& username);
+    bool validateSession(const std::string& token, std::string& username, Role& role);
+    void endSession(const std::string& token);
+
+    // Between beginBatch() and endBatch() journal lines are buffered and appended
+    // with one write; the in-memory store is updated immediately as usual
+    void beginBatch();
+    void endBatch();
+
+    // scrypt cost (log2 N) used for new hashes; admins default to a higher cost than users
+    void setHashCost(Role role, int cost);
+    int getHashCost(Role role) const;
 
 private:
-    std::unordered_map<std::string, std::pair<std::size_t, Role>> users;
+    // Logins only take a shared lock on one stripe of the store. Mutators also
+    // hold mutationMutex, which orders the journal and guards the directory and
+    // compaction state; password hashing always happens outside of it.
+    CredentialStore<Credential> users;
+    mutable std::mutex mutationMutex;
+    UserDirectory directory; // Kept in sync with users by every mutator
     const std::string HASHED_USERS_FILE = "output/hashed_users.txt";
     const std::string HASHED_ADMINS_FILE = "output/hashed_admins.txt";
+    // Every change is one appended journal line; the two files above are the checkpoint
+    const std::string USERS_JOURNAL_FILE = "output/users_journal.log";
+    const std::string USERS_JOURNAL_COMPACTING_FILE = "output/users_journal.log.compacting";
+    static const std::size_t JOURNAL_COMPACTION_THRESHOLD = 1000;
+    std::size_t journalEntries;
+    std::uint64_t userTableVersion; // Last stamp handed out; guarded by mutationMutex
+    int batchDepth;
+    std::string pendingJournal;
+    std::size_t pendingJournalEntries;
+    std::thread compactionThread;
+    std::atomic<bool> compactionRunning;
+    std::atomic<int> userHashCost;
+    std::atomic<int> adminHashCost;
+    ThreadPool verifyPool;
+    SessionStore sessions;
 
-    std::size_t hash_password(const std::string& password);
+    std::string hash_password(const std::string& password, Role role);
+    static LoginResult verifyCredential(const std::string& password, const Credential& credential, int targetCost);
+    bool register_account(const std::string& username, const std::string& password, Role role);
+    // Reads, validates and hashes an import file; touches the store only through lookups
+    PreparedImport prepare_import(const std::string& path, int userCost, int adminCost, ImportProgress* progress) const;
     void load_users();
-    void save_users();
+    void load_checkpoint(const std::string& path, Role role);
+    void stamp_loaded(Credential& credential, bool hasVersion);
+    void rebuild_directory();
+    std::size_t replay_journal(const std::string& path);
+    void journal_put(const std::string& username, const Credential& credential);
+    void journal_delete(const std::string& username);
+    void journal_append(const std::string& lines, std::size_t entries);
+    void start_compaction();
+    bool save_users(const std::unordered_map<std::string, Credential>& snapshot) const;
 };
 
 #endif // AUTH_HPP
@@ -0,0 +1,18 @@
+#ifndef COMPRESSION_HPP
+#define COMPRESSION_HPP
+
+#include <cstddef>
+#include <string>
+
+// Small LZ77 byte compressor in the LZ4 block layout: each sequence is a token
+// (literal count, match length - 4), the literals, a 16-bit match offset and
+// any length overflow bytes. Fast to run and decent on repetitive records such
+// as queued offline actions; not meant as a general archive format.
+class Compression {
+public:
+    static std::string compress(const std::string& input);
+    // False if the data is damaged or does not expand to exactly originalSize bytes
+    static bool decompress(const std::string& input, std::size_t originalSize, std::string& output);
+};
+
+#endif // COMPRESSION_HPP
@@ -0,0 +1,120 @@
+#ifndef CREDENTIALSTORE_HPP
+#define CREDENTIALSTORE_HPP
+
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+
+// Concurrent username -> value map split over independently locked stripes.
+// Lookups take a shared lock on one stripe only, so logins on different
+// threads never wait for each other and only wait for a writer that happens
+// to touch the same stripe. Values are copied out, never referenced.
+template <typename Value>
+class CredentialStore {
+public:
+    static const std::size_t STRIPE_COUNT = 64;
+
+    bool find(const std::string& key, Value& value) const {
+        const Stripe& stripe = stripeFor(key);
+        std::shared_lock<std::shared_mutex> lock(stripe.mutex);
+        auto it = stripe.entries.find(key);
+        if (it == stripe.entries.end()) {
+            return false;
+        }
+        value = it->second;
+        return true;
+    }
+
+    bool contains(const std::string& key) const {
+        const Stripe& stripe = stripeFor(key);
+        std::shared_lock<std::shared_mutex> lock(stripe.mutex);
+        return stripe.entries.find(key) != stripe.entries.end();
+    }
+
+    // Fails without touching the existing value if the key is already present
+    bool insert(const std::string& key, const Value& value) {
+        Stripe& stripe = stripeFor(key);
+        std::unique_lock<std::shared_mutex> lock(stripe.mutex);
+        return stripe.entries.emplace(key, value).second;
+    }
+
+    void put(const std::string& key, const Value& value) {
+        Stripe& stripe = stripeFor(key);
+        std::unique_lock<std::shared_mutex> lock(stripe.mutex);
+        stripe.entries[key] = value;
+    }
+
+    bool erase(const std::string& key) {
+        Stripe& stripe = stripeFor(key);
+        std::unique_lock<std::shared_mutex> lock(stripe.mutex);
+        return stripe.entries.erase(key) > 0;
+    }
+
+    // Runs update(value) under the stripe's exclusive lock; the update returns
+    // false to signal that it left the value unchanged (e.g. a failed compare)
+    template <typename F>
+    bool update(const std::string& key, F update) {
+        Stripe& stripe = stripeFor(key);
+        std::unique_lock<std::shared_mutex> lock(stripe.mutex);
+        auto it = stripe.entries.find(key);
+        if (it == stripe.entries.end()) {
+            return false;
+        }
+        return update(it->second);
+    }
+
+    // Visits stripe by stripe; not a point-in-time view if writers run concurrently
+    template <typename F>
+    void forEach(F visit) const {
+        for (const auto& stripe : stripes) {
+            std::shared_lock<std::shared_mutex> lock(stripe.mutex);
+            for (const auto& entry : stripe.entries) {
+                visit(entry.first, entry.second);
+            }
+        }
+    }
+
+    std::unordered_map<std::string, Value> snapshot() const {
+        std::unordered_map<std::string, Value> copy;
+        copy.reserve(size());
+        forEach([&copy](const std::string& key, const Value& value) { copy.emplace(key, value); });
+        return copy;
+    }
+
+    std::size_t size() const {
+        std::size_t total = 0;
+        for (const auto& stripe : stripes) {
+            std::shared_lock<std::shared_mutex> lock(stripe.mutex);
+            total += stripe.entries.size();
+        }
+        return total;
+    }
+
+    void clear() {
+        for (auto& stripe : stripes) {
+            std::unique_lock<std::shared_mutex> lock(stripe.mutex);
+            stripe.entries.clear();
+        }
+    }
+
+private:
+    // Cache-line aligned so neighbouring stripe locks do not false-share
+    struct alignas(64) Stripe {
+        mutable std::shared_mutex mutex;
+        std::unordered_map<std::string, Value> entries;
+    };
+
+    Stripe stripes[STRIPE_COUNT];
+
+    Stripe& stripeFor(const std::string& key) {
+        return stripes[std::hash<std::string>{}(key) % STRIPE_COUNT];
+    }
+    const Stripe& stripeFor(const std::string& key) const {
+        return stripes[std::hash<std::string>{}(key) % STRIPE_COUNT];
+    }
+};
+
+#endif // CREDENTIALSTORE_HPP
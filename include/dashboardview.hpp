@@ -0,0 +1,115 @@
+#ifndef DASHBOARDVIEW_HPP
+#define DASHBOARDVIEW_HPP
+
+#include "history.hpp"
+#include "offlinemechanism.hpp"
+#include "replication.hpp"
+#include "room.hpp"
+#include "userdirectory.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Headless part of the dashboard: which rooms the floor plan shows and where,
+// the status lines and the rows of the list popups. Nothing here calls raylib,
+// so the cost of a frame can be measured without a display
+// (bench/frame_bench.cpp); gui_main.cpp only draws what it produces.
+// Results are kept between frames and text is formatted into the strings it
+// already has, so a frame where nothing changed does not allocate.
+class DashboardView {
+public:
+    struct Filter {
+        const char* search = "";      // Case-insensitive substring of the room name
+        bool availableOnly = false;
+        bool bookedOnly = false;      // Both checked cancel each other out
+        const char* minCapacity = ""; // Ignored unless it is a number
+    };
+
+    // Floor plan area in screen coordinates; tiles fill rows from its top-left corner
+    struct Layout {
+        float x = 0;
+        float y = 0;
+        float width = 0;
+        float height = 0;
+        float scrollX = 0; // As kept by the scroll panel, <= 0
+        float scrollY = 0;
+        float tileWidth = 180;
+        float tileHeight = 100;
+        float padding = 20;
+    };
+
+    struct Tile {
+        const Room* room;
+        float x;
+        float y;
+    };
+
+    enum class Tone {
+        NORMAL,
+        WARNING,
+        ALERT
+    };
+
+    struct StatusLine {
+        bool visible = false;
+        std::string text;
+        Tone tone = Tone::NORMAL;
+    };
+
+    struct Status {
+        StatusLine sync;        // Only while a sync runs
+        StatusLine durability;
+        StatusLine replication;
+        StatusLine queue;       // While offline or while actions are queued
+    };
+
+    DashboardView(RoomManager& rm, OfflineManager& offline);
+
+    // Call with the state lock held. While offline the projected rooms are shown.
+    void updateFloorPlan(const Filter& filter);
+    // The next update filters again even if no input changed, e.g. after rooms were reloaded
+    void invalidate();
+    const std::vector<Room>& getShownRooms() const;
+    std::size_t getMatchCount() const;
+    int getColumns(const Layout& layout) const;
+    float getContentHeight(const Layout& layout) const;
+    // Matching rooms in the rows that intersect the view
+    const std::vector<Tile>& layoutTiles(const Layout& layout);
+
+    // replication is nullptr when no peer is configured
+    const Status& updateStatus(const Replicator::Stats* replication);
+
+    // Rows of the list popups
+    static std::string formatRoomHistory(const RoomHistoryEntry& entry);
+    static std::string formatBookingHistory(const BookingHistoryEntry& entry);
+    static std::string formatAccount(const UserDirectory::Entry& entry);
+    static std::string formatPageText(std::size_t page, std::size_t pageCount, std::size_t total, const char* noun);
+
+    // Times the room filter ran, for checking that idle frames reuse it
+    std::uint64_t getFilterRuns() const;
+
+private:
+    RoomManager& rm;
+    OfflineManager& offline;
+
+    const std::vector<Room>* shownRooms;
+    std::vector<std::size_t> matches; // Positions in *shownRooms
+    std::vector<Tile> tiles;
+    bool dirty;
+    std::string filteredSearch;
+    std::string filteredCapacity;
+    bool filteredAvailable;
+    bool filteredBooked;
+    bool filteredOffline;
+    std::uint64_t filteredRoomsVersion;
+    std::uint64_t filteredProjectedVersion;
+    std::string searchLower;
+    std::string nameLower;
+    std::uint64_t filterRuns;
+
+    Status status;
+    std::size_t durabilityFsyncs;
+};
+
+#endif // DASHBOARDVIEW_HPP
@@ -0,0 +1,58 @@
+#ifndef DURABILITY_HPP
+#define DURABILITY_HPP
+
+#include <cstddef>
+#include <string>
+
+// Single write path for every persisted file (rooms, users, history logs and the
+// offline queue). The level decides when data is forced to stable storage:
+//   NONE          - rely on the OS page cache, never fsync
+//   GROUP_COMMIT  - a background committer fsyncs all files touched in the last N ms
+//   PER_OPERATION - fsync before every write call returns
+class Durability {
+public:
+    enum class Level {
+        NONE,
+        GROUP_COMMIT,
+        PER_OPERATION
+    };
+
+    struct Metrics {
+        std::size_t writes = 0;       // writeFile() + append() + truncate() calls
+        std::size_t fsyncCount = 0;
+        double totalFsyncMs = 0.0;
+        double maxFsyncMs = 0.0;
+        double lastFsyncMs = 0.0;
+        std::size_t pendingFiles = 0; // Dirty files waiting for the next group commit
+    };
+
+    static void configure(Level level, int groupCommitIntervalMs = 50);
+    // Reads IFM_DURABILITY = none | group[:<ms>] | fsync, defaults to group commit
+    static void configureFromEnvironment();
+    static Level getLevel();
+    static int getGroupCommitInterval();
+    static std::string describe();
+
+    // Replaces the file atomically (write to a temp file, then rename over it)
+    static bool writeFile(const std::string& path, const std::string& contents);
+    static bool append(const std::string& path, const std::string& data);
+    // Cuts the file to its first `size` bytes, e.g. to drop a torn record from a log
+    static bool truncate(const std::string& path, std::size_t size);
+    // Forces any pending group-commit work to disk now
+    static void flush();
+
+    // Writes and appends this thread makes between beginTransaction() and
+    // commitTransaction() are held back, saved together in a commit record and
+    // only then applied, so a crash leaves either all of them or none: recover()
+    // finishes a record left behind on the next start. Nests; the outermost
+    // commit applies. truncate() is never held back.
+    static void beginTransaction();
+    static bool commitTransaction();
+    static bool inTransaction();
+    // Call at startup before any persisted file is read; true if a commit was finished
+    static bool recover();
+
+    static Metrics getMetrics();
+};
+
+#endif // DURABILITY_HPP
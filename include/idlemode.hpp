@@ -0,0 +1,44 @@
+#ifndef IDLEMODE_HPP
+#define IDLEMODE_HPP
+
+#include <cstdint>
+#include <functional>
+#include <string>
+
+// Lets the GUI sleep while nothing on screen can change. Each frame that
+// follows input keeps the loop drawing for a short grace period, since raygui
+// shows the result of a click one frame later. After that, EndDrawing() waits
+// for the next event: input, a timer set with wakeAfter(), or a change in one of
+// the watched values, which a background thread samples a few times a second.
+//   IDLE        - wait for events between frames (default)
+//   CONTINUOUS  - draw every frame at the target FPS, as before
+class IdleMode {
+public:
+    enum class Mode {
+        IDLE,
+        CONTINUOUS
+    };
+
+    // Sampled off the GUI thread, so it must be thread-safe; a new value wakes the loop
+    using Probe = std::function<std::uint64_t()>;
+
+    static void configure(Mode mode);
+    // Reads IFM_RENDER = idle | continuous, defaults to idle
+    static void configureFromEnvironment();
+    static Mode getMode();
+    static std::string describe();
+
+    static void watch(Probe probe);
+    // The loop wakes no later than this many seconds from now
+    static void wakeAfter(double seconds);
+    // Something on screen is still moving (e.g. sync progress); draw the next frame without waiting
+    static void keepAwake();
+    // Call once per frame before EndDrawing(); decides whether the next frame waits
+    static void endFrame();
+    // Stops the sampling thread; call before the window is closed
+    static void shutdown();
+
+    static std::uint64_t getWakeCount(); // Frames started by an event after waiting
+};
+
+#endif // IDLEMODE_HPP
@@ -22,6 +22,9 @@ public:
     Room* bookRoom(const std::string& username, int participants, const std::string& roomName);
     ReleaseRoomStatus releaseRoom(const std::string& username, const std::string& roomName, bool isGui = false);
     void showRoomStatuses(const std::string& username);
+    // Buffers booking history appends; rooms.txt is deferred by RoomManager's own batch
+    void beginBatch();
+    void endBatch();
 
 private:
     RoomManager& rm;
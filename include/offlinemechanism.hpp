@@ -5,40 +5,248 @@
 #include "auth.hpp"
 #include "room.hpp"
 #include "meetingroom.hpp"
+#include "offlineoverlay.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// One queued offline action. Field use depends on the type:
+//   UPLOAD_ROOM / MODIFY_ROOM: actor = admin, target = room, number = capacity, flag = available
+//   REGISTER_NEW_ADMIN:        actor = admin, target = new admin, secret = password
+//   BOOK_ROOM:                 actor = user, target = room (empty = any), number = participants
+//   RELEASE_ROOM:              actor = user, target = room
+//   DELETE_ROOM:               actor = admin, target = room
+//   DELETE_USER:               target = user
+//   EDIT_USER:                 target = user, secret = new password, role = new role
+// The base* fields record what the target looked like when the op was queued:
+// its version (0 = did not exist) and, for MODIFY_ROOM and EDIT_USER, the old
+// capacity/availability or role that a merge compares against.
+struct OfflineOp {
+    enum class Type : std::uint8_t {
+        UPLOAD_ROOM,
+        MODIFY_ROOM,
+        REGISTER_NEW_ADMIN,
+        BOOK_ROOM,
+        DELETE_USER,
+        EDIT_USER,
+        DELETE_ROOM,
+        RELEASE_ROOM
+    };
+
+    Type type;
+    std::string actor;
+    std::string target;
+    std::string secret;
+    int number = 0;
+    bool flag = false;
+    Authentication::Role role = Authentication::Role::USER;
+    std::uint64_t seq = 0; // Assigned when queued; increases monotonically across syncs
+    std::uint64_t baseVersion = 0;
+    int baseNumber = 0;
+    bool baseFlag = false;
+    Authentication::Role baseRole = Authentication::Role::USER;
+
+    std::string describe() const; // Same text the old line-based queue file used
+};
 
 class OfflineManager {
 public:
+    struct SyncProgress {
+        bool running;
+        std::size_t applied;
+        std::size_t total;
+    };
+
+    // What to do with an op whose target changed after it was queued:
+    //   REJECT           - skip the op
+    //   LAST_WRITER_WINS - apply it anyway, overwriting the newer change
+    //   MERGE            - keep fields only the other side changed; deletes of a changed target are skipped
+    enum class ConflictPolicy {
+        REJECT,
+        LAST_WRITER_WINS,
+        MERGE
+    };
+
+    struct SyncConflict {
+        std::string operation; // describe() text with the password masked
+        std::uint64_t baseVersion;
+        std::uint64_t currentVersion;
+        std::string resolution;
+    };
+
     OfflineManager(Authentication& auth, RoomManager& rm, RoomBookingSystem& rbs);
+    ~OfflineManager();
     void goOffline();
-    void goOnline();
+    void goOnline(); // Synchronizes on the calling thread
     bool isOffline() const;
 
-    void queueUploadRoom(const std::string& adminName, const std::string& roomName, int capacity, bool isAvailable);
-    void queueModifyRoom(const std::string& adminName, const std::string& roomName, int capacity, bool isAvailable);
-    void queueRegisterNewAdmin(const std::string& adminName, const std::string& newAdminUsername, const std::string& newAdminPassword);
-    void queueBookRoom(const std::string& username, int participants, const std::string& roomName);
-    void queueDeleteUser(const std::string& targetUsername);
-    void queueEditUser(const std::string& targetUsername, const std::string& newPassword, Authentication::Role newRole);
-    void queueDeleteRoom(const std::string& roomName, const std::string& adminName);
-    void queueReleaseRoom(const std::string& username, const std::string& roomName); // New method
-    std::vector<std::string> getQueueForDisplay();
+    // Background synchronization. The worker applies one op at a time while
+    // holding the state lock; anyone else touching the room manager, booking
+    // system or this queue while a sync may be running must hold it too (the
+    // GUI holds it for each frame until just before EndDrawing()).
+    void goOnlineInBackground();
+    bool startBackgroundSync(); // False if a sync is already running
+    void cancelSync();          // Unapplied ops stay queued for the next sync
+    SyncProgress getSyncProgress() const;
+    // Takes the state lock; a running sync hands it over after its current op
+    std::unique_lock<std::mutex> acquireState();
+
+    // Defaults to IFM_CONFLICT_POLICY = reject | lww | merge, or last-writer-wins when unset
+    void setConflictPolicy(ConflictPolicy policy);
+    ConflictPolicy getConflictPolicy() const;
+    // Conflicts found by the last sync; read under the state lock
+    const std::vector<SyncConflict>& getLastConflicts() const;
+
+    // Replay workers per sync; 0 = one per hardware thread, 1 = strictly serial
+    void setReplayThreads(std::size_t threads);
+
+    // How full the queue is, so producers can back off:
+    //   NORMAL   - every queued action is held in memory
+    //   SPILLING - the memory budget was exceeded and the oldest actions live in compressed segments on disk
+    //   FULL     - the spill limit is used up too; new actions are refused until a sync drains the queue
+    enum class QueuePressure {
+        NORMAL,
+        SPILLING,
+        FULL
+    };
+
+    struct QueueMetrics {
+        std::size_t queuedOps;   // In memory plus spilled
+        std::size_t memoryOps;
+        std::size_t memoryBytes; // Estimated, including the display lines
+        std::size_t memoryBudget;
+        std::size_t spilledOps;
+        std::size_t spilledSegments;
+        std::size_t spilledBytes; // Compressed, on disk
+        std::size_t spillLimit;
+        QueuePressure pressure;
+    };
+
+    // Defaults to IFM_OFFLINE_MEMORY (4M) and IFM_OFFLINE_SPILL_LIMIT (256M); sizes
+    // take a K, M or G suffix. A spill limit of 0 keeps the queue in memory only.
+    void setQueueBudget(std::size_t memoryBytes, std::size_t spillLimitBytes);
+    QueueMetrics getQueueMetrics() const; // Read under the state lock
+    QueuePressure getQueuePressure() const;
+
+    // False when the action was not queued: the queue is full or it could not be saved
+    bool queueUploadRoom(const std::string& adminName, const std::string& roomName, int capacity, bool isAvailable);
+    bool queueModifyRoom(const std::string& adminName, const std::string& roomName, int capacity, bool isAvailable);
+    bool queueRegisterNewAdmin(const std::string& adminName, const std::string& newAdminUsername, const std::string& newAdminPassword);
+    bool queueBookRoom(const std::string& username, int participants, const std::string& roomName);
+    bool queueDeleteUser(const std::string& targetUsername);
+    bool queueEditUser(const std::string& targetUsername, const std::string& newPassword, Authentication::Role newRole);
+    bool queueDeleteRoom(const std::string& roomName, const std::string& adminName);
+    bool queueReleaseRoom(const std::string& username, const std::string& roomName); // New method
+    // The state rooms and accounts will have after the next sync, for showing
+    // while offline; read under the state lock like the real managers
+    const std::vector<Room>& getProjectedRooms();
+    const Room* findProjectedRoom(const std::string& roomName);
+    bool findProjectedUser(const std::string& username, Authentication::Role& role);
+    // Moves whenever the projected state may have changed apart from the rooms themselves
+    std::uint64_t getProjectedVersion() const;
+
+    // Served from memory; the lines are only rebuilt when the queue version changes.
+    // Spilled actions are summed up in a first line instead of being listed.
+    const std::vector<std::string>& getQueueForDisplay();
+    std::uint64_t getQueueVersion() const;
 
 private:
     bool offline;
+    // Pre-binary-log queue; migrated into the log on startup if present
     const std::string OFFLINE_CHANGES_FILE = "output/offline_changes.txt";
+    // Records are [u32 payload length][payload][u32 checksum]; a torn tail is truncated on load
+    const std::string OFFLINE_QUEUE_LOG = "output/offline_queue.log";
+    // "<seq> <offset>" of the last op whose effects are persisted; loading resumes right after it
+    const std::string SYNC_CHECKPOINT_FILE = "output/offline_sync.checkpoint";
+    // Most ops replayed in parallel at once; progress is checkpointed about this often
+    static const std::size_t REPLAY_PHASE_LIMIT = 2048;
+    // Report of the last sync that found conflicts
+    const std::string SYNC_CONFLICTS_FILE = "output/sync_conflicts.txt";
+    // Actions spilled out of memory, one "<first seq>.seg" file per spill: a
+    // 32-byte header, then queue log records compressed as one block
+    const std::string OFFLINE_SPILL_DIR = "output/offline_spill";
+
+    struct SpillSegment {
+        std::string path;
+        std::uint64_t firstSeq;
+        std::uint64_t lastSeq;
+        std::size_t count;
+        std::size_t bytes; // File size
+    };
+
+    std::vector<OfflineOp> queue; // Newest actions; everything in segments is older
+    std::size_t queueBytes;
+    std::vector<SpillSegment> segments; // Oldest first
+    std::size_t spilledOps;
+    std::size_t spilledBytes;
+    std::size_t memoryBudget;
+    std::size_t spillLimit;
+    std::uint64_t appliedThrough; // From the checkpoint: ops up to here were applied and are skipped when read back
+    bool replaying;               // Sync holds indices into queue, so spilling waits until it is done
+    std::uint64_t nextSeq;
+    std::uint64_t queueVersion;
+    std::vector<std::string> displayCache;
+    std::uint64_t displayVersion;
+
+    std::mutex stateMutex;
+    std::atomic<int> stateWaiters;
+    std::thread syncThread;
+    std::atomic<bool> syncRunning;
+    std::atomic<bool> cancelRequested;
+    std::atomic<std::size_t> syncApplied;
+    std::atomic<std::size_t> syncTotal;
+    std::atomic<ConflictPolicy> conflictPolicy;
+    std::vector<SyncConflict> lastConflicts;
+    std::atomic<std::size_t> replayThreads;
+    std::shared_mutex roomStructure; // Shared while replaying in-place room ops, exclusive for uploads and deletes
 
+    // Per key during one sync: the base its applied ops had and the version they produced
+    struct KeyState {
+        bool adopted = false;
+        std::uint64_t base = 0;
+        std::uint64_t version = 0;
+    };
 
     Authentication& auth;
     RoomManager& rm;
     RoomBookingSystem& rbs;
+    OfflineOverlay overlay; // Queue applied on top of rm/auth; kept in step by enqueue() and sync
 
+    void loadQueue();
+    void migrateLegacyQueue();
+    bool enqueue(OfflineOp op);
+    std::vector<std::uint64_t> rewriteLog();
+    void loadSegments(std::uint64_t checkpointSeq);
+    void spillOldest();
+    bool writeSegment(const std::vector<OfflineOp>& ops, std::size_t count, SpillSegment& segment);
+    bool readSegment(const SpillSegment& segment, std::vector<OfflineOp>& ops);
+    void recountQueueBytes();
+    void rebuildOverlay();
+    bool writeCheckpoint(std::uint64_t seq, std::uint64_t offset);
+    std::vector<OfflineOp> compactQueue(const std::vector<OfflineOp>& ops);
+    // passwordHash is the record for REGISTER_NEW_ADMIN and EDIT_USER, hashed beforehand
+    void applyOperation(const OfflineOp& op, const std::string& passwordHash);
+    void replayOperation(OfflineOp op, const std::string& passwordHash, KeyState& key, std::vector<SyncConflict>& conflicts);
+    std::uint64_t currentVersion(const OfflineOp& op);
+    bool resolveConflict(OfflineOp& op, std::uint64_t current, std::string& resolution);
+    void recordBase(OfflineOp& op);
     void synchronizeChanges();
+    // Replays ops[0, total) in phases and marks what was applied in done; the
+    // offsets locate each op in the log for checkpoints (0 for spilled ops)
+    void replayOps(std::vector<OfflineOp>& ops, std::size_t total, std::vector<char>& done, const std::vector<std::uint64_t>& offsets,
+                   std::unordered_map<std::string, KeyState>& keys, std::unique_lock<std::mutex>& lock);
     void applyUploadRoom(const std::string& adminName, const std::string& roomName, int capacity, bool isAvailable);
     void applyModifyRoom(const std::string& adminName, const std::string& roomName, int capacity, bool isAvailable);
-    void applyRegisterNewAdmin(const std::string& adminName, const std::string& newAdminUsername, const std::string& newAdminPassword);
+    void applyRegisterNewAdmin(const std::string& adminName, const std::string& newAdminUsername, const std::string& passwordHash);
     void applyBookRoom(const std::string& username, int participants, const std::string& roomName);
     void applyDeleteUser(const std::string& targetUsername);
-    void applyEditUser(const std::string& targetUsername, const std::string& newPassword, Authentication::Role newRole);
+    void applyEditUser(const std::string& targetUsername, const std::string& passwordHash, Authentication::Role newRole);
     void applyDeleteRoom(const std::string& roomName, const std::string& adminName);
     void applyReleaseRoom(const std::string& username, const std::string& roomName); // New method
 };
@@ -0,0 +1,65 @@
+#ifndef OFFLINEOVERLAY_HPP
+#define OFFLINEOVERLAY_HPP
+
+#include "auth.hpp"
+#include "room.hpp"
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct OfflineOp;
+
+// What rooms and accounts will look like once the offline queue is synced: the
+// real RoomManager/Authentication state with the queued ops applied on top.
+// A room or account is copied into the overlay the first time an op touches
+// it; everything else reads straight through, so lookups stay O(1) and
+// applying an op costs O(1) (a BOOK_ROOM without a room name has to look at
+// every room, like the real booking does).
+class OfflineOverlay {
+public:
+    OfflineOverlay(RoomManager& rm, Authentication& auth);
+
+    void apply(const OfflineOp& op);
+    void rebuild(const std::vector<OfflineOp>& ops); // Drops everything, then applies ops in order
+    void clear();
+    bool empty() const;
+
+    // nullptr when the room does not exist in the projected state
+    const Room* findRoom(const std::string& roomName);
+    bool findUser(const std::string& username, Authentication::Role& role);
+    // Same order RoomManager would end up with; rebuilt only when the overlay or the rooms change
+    const std::vector<Room>& getRooms();
+    std::uint64_t getVersion() const;
+
+    // Rooms changed by a queued op carry this bit plus the overlay version in
+    // their stamp, so a projected state never shares a stamp with a real one
+    static const std::uint64_t PROJECTED_STAMP = std::uint64_t(1) << 63;
+
+private:
+    struct RoomEntry {
+        std::optional<Room> room; // Empty = deleted (or never existed)
+        bool appended = false;    // Created by the overlay, listed after the real rooms
+    };
+
+    RoomManager& rm;
+    Authentication& auth;
+    std::unordered_map<std::string, RoomEntry> rooms;
+    std::vector<std::string> appendedOrder;
+    std::unordered_map<std::string, std::optional<Authentication::Role>> users;
+    std::uint64_t version;
+
+    std::vector<Room> roomsCache;
+    std::uint64_t cachedVersion;
+    std::uint64_t cachedRoomsVersion;
+
+    RoomEntry& touchRoom(const std::string& roomName);
+    std::optional<Authentication::Role>& touchUser(const std::string& username);
+    void applyBooking(const OfflineOp& op, const std::string& roomName);
+    // Visits the projected rooms in getRooms() order without building the cache
+    template <typename Visit>
+    void forEachRoom(Visit visit);
+};
+
+#endif // OFFLINEOVERLAY_HPP
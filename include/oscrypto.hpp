@@ -0,0 +1,17 @@
+#ifndef OSCRYPTO_HPP
+#define OSCRYPTO_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+// The operating system's CSPRNG (BCryptGenRandom on Windows, /dev/urandom
+// elsewhere). Used for anything an attacker must not predict: password salts
+// and session tokens. std::random_device is not enough, since older MinGW
+// builds implement it as a fixed-seed generator.
+class OsCrypto {
+public:
+    // Throws std::runtime_error when the OS source cannot be read; there is no weaker fallback
+    static void fillRandom(std::uint8_t* buffer, std::size_t length);
+};
+
+#endif // OSCRYPTO_HPP
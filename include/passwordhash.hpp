@@ -0,0 +1,33 @@
+#ifndef PASSWORDHASH_HPP
+#define PASSWORDHASH_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Salted, memory-hard password hashing (scrypt built on PBKDF2-HMAC-SHA256).
+// Stored records look like "scrypt$<cost>$<saltHex>$<hashHex>" where the scrypt
+// work factor is N = 2^cost, so every record carries its own cost. Records
+// written by older builds (a bare std::hash value) are still accepted.
+class PasswordHasher {
+public:
+    static const int DEFAULT_COST = 14; // N = 16384, ~16 MiB per verification
+    static const int MIN_COST = 10;
+    static const int MAX_COST = 20;
+
+    // The salt comes from OsCrypto; throws std::runtime_error if it cannot be read
+    static std::string hash(const std::string& password, int cost = DEFAULT_COST);
+    static bool verify(const std::string& password, const std::string& record);
+    static int getCost(const std::string& record); // 0 for legacy records
+    static bool isLegacy(const std::string& record);
+    // True for legacy records or ones hashed with a lower cost than requested
+    static bool needsRehash(const std::string& record, int cost);
+
+    static std::vector<std::uint8_t> sha256(const std::uint8_t* data, std::size_t length);
+    static std::vector<std::uint8_t> pbkdf2Sha256(const std::string& password, const std::uint8_t* salt, std::size_t saltLength,
+                                                  std::uint32_t iterations, std::size_t outputLength);
+    static std::vector<std::uint8_t> scrypt(const std::string& password, const std::uint8_t* salt, std::size_t saltLength,
+                                            std::uint64_t n, std::uint32_t r, std::uint32_t p, std::size_t outputLength);
+};
+
+#endif // PASSWORDHASH_HPP
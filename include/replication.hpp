@@ -0,0 +1,128 @@
+#ifndef REPLICATION_HPP
+#define REPLICATION_HPP
+
+#include "room.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Shares room state between instances over TCP. Every room change seen by the
+// RoomManager observer becomes a delta holding the room's full new state,
+// stamped with a Lamport clock and this instance's origin id. Deltas for the
+// same room are coalesced until they are sent, so a busy room costs one
+// delta per batch. The peer keeps whichever delta has the higher (clock,
+// origin) stamp, so both sides end up with the same state whatever order
+// changes arrive in.
+//
+// A connection sends its changes one way: this instance connects to the peer
+// and ships deltas, and the peer acks them. Two front desks that should share
+// state both listen and point at each other. On the wire every frame is
+// [u32 length][u8 type][body], integers inside the body are varints:
+//   HELLO  origin, clock      - both sides, first thing on a connection
+//   BATCH  first seq, count, deltas
+//   ACK    highest seq received
+// A peer seen for the first time (or restarted) gets a snapshot of every room;
+// after a reconnect to the same peer only the unacked deltas are sent again.
+//
+// Changes are applied to this instance's rooms by poll(), which the GUI calls
+// every frame while it holds the state lock. Only rooms are replicated.
+class Replicator {
+public:
+    struct Stats {
+        bool listening = false;
+        bool peerConnected = false;   // Outbound connection is up and past HELLO
+        std::size_t inboundPeers = 0;
+        std::size_t pendingDeltas = 0; // Queued or sent but not yet acked
+        std::uint64_t deltasSent = 0;
+        std::uint64_t deltasApplied = 0;
+        std::uint64_t bytesSent = 0;
+        std::uint64_t bytesReceived = 0;
+    };
+
+    explicit Replicator(RoomManager& rm);
+    ~Replicator();
+
+    // Either part may be left out: port 0 = do not listen, empty host = no peer
+    bool start(const std::string& listenHost, unsigned short listenPort, const std::string& peerHost, unsigned short peerPort);
+    // Reads IFM_REPLICA_LISTEN = [<host>:]<port> and IFM_REPLICA_PEER = <host>:<port>;
+    // false when neither is set or the listen port cannot be opened. Listening
+    // binds to 127.0.0.1 unless a host is given.
+    bool configureFromEnvironment();
+    bool isRunning() const;
+
+    // While paused (the instance is offline) connections are dropped and changes queue up
+    void setPaused(bool paused);
+    // Applies changes received from peers; call with the state lock held
+    void poll();
+    Stats getStats() const;
+
+private:
+    // Ordered by clock, then origin, so every instance picks the same winner
+    struct Stamp {
+        std::uint64_t clock = 0;
+        std::uint64_t origin = 0;
+        bool operator<(const Stamp& other) const {
+            return clock != other.clock ? clock < other.clock : origin < other.origin;
+        }
+    };
+
+    struct Delta {
+        std::string room;
+        bool deleted = false;
+        int capacity = 0;
+        bool available = false;
+        std::string bookedBy;
+        std::string modifiedBy;
+        Stamp stamp;
+    };
+
+    // Most deltas per BATCH frame
+    static const std::size_t MAX_BATCH_DELTAS = 512;
+
+    RoomManager& rm;
+    std::uint64_t origin;
+    std::string peerHost;
+    unsigned short peerPort;
+
+    mutable std::mutex mutex; // Everything below up to the counters
+    std::uint64_t clock;
+    std::unordered_map<std::string, Delta> latest; // Current state per room, tombstones included
+    std::vector<std::string> latestOrder;           // Snapshots list rooms in the order they were first seen
+    std::unordered_map<std::string, Delta> pending; // Not sent yet, coalesced per room
+    std::vector<std::string> pendingOrder;
+    std::deque<std::pair<std::uint64_t, Delta>> inflight; // Sent, waiting for an ack
+    std::uint64_t nextSeq;
+    std::uint64_t peerOrigin;                             // Peer the outbound connection last talked to
+    std::unordered_map<std::uint64_t, std::uint64_t> receivedSeq; // Highest seq applied per sending origin
+    std::vector<Delta> inbox;
+
+    std::atomic<bool> running;
+    std::atomic<bool> paused;
+    std::atomic<bool> applying; // Set while poll() changes rooms, so those changes are not sent back
+    std::atomic<bool> listening;
+    std::atomic<bool> peerConnected;
+    std::atomic<std::size_t> inboundPeers;
+    std::atomic<std::uint64_t> deltasSent;
+    std::atomic<std::uint64_t> deltasApplied;
+    std::atomic<std::uint64_t> bytesSent;
+    std::atomic<std::uint64_t> bytesReceived;
+    std::thread worker;
+
+    void capture(const std::string& roomName, const Room* room);
+    void queuePending(const Delta& delta);
+    void requeueInflight();
+    void networkLoop(std::intptr_t listener); // The listening socket, or -1
+    // Frame handlers; called on the network thread, return false to drop the connection
+    std::string encodeHello();
+    std::string takeBatch();
+    bool handleOutbound(std::uint8_t type, const std::string& body);
+    bool handleInbound(std::uint8_t type, const std::string& body, std::uint64_t& sender, std::string& reply);
+};
+
+#endif // REPLICATION_HPP
@@ -1,7 +1,11 @@
 #ifndef ROOM_HPP
 #define ROOM_HPP
 
+#include <atomic>
+#include <cstdint>
+#include <functional>
 #include <string>
+#include <unordered_map>
 #include <vector>
 #include <ctime>
 
@@ -17,12 +21,15 @@ public:
     int getCapacity() const;
     bool isAvailable() const;
     std::string getBookedBy() const;
+    // Stamp of the last change, unique within its RoomManager; 0 until the room is stored
+    std::uint64_t getVersion() const;
 
     void setCapacity(int capacity);
     void setAvailable(bool isAvailable);
     void setLastModifiedBy(const std::string& adminName);
     void setTimestamp(time_t timestamp);
     void setBookedBy(const std::string& username);
+    void setVersion(std::uint64_t version);
 
 private:
     std::string name;
@@ -31,6 +38,7 @@ private:
     int capacity;
     bool m_isAvailable;
     std::string bookedBy;
+    std::uint64_t version;
 };
 
 class RoomManager {
@@ -46,11 +54,41 @@ public:
     Room* findRoom(const std::string& roomName);
     void addRoom(const std::string& adminName, const std::string& roomName, int capacity, bool isAvailable = true);
     void deleteRoom(const std::string& roomName, const std::string& adminName);
+    // Creates the room, or overwrites every field of an existing one, from a full
+    // state; replication applies changes made on another instance this way
+    void putRoom(const Room& state);
+
+    // Called after every change with the room's new state, or nullptr once it is
+    // deleted. Offline replay changes rooms from several threads, so the observer
+    // must be thread-safe.
+    using ChangeObserver = std::function<void(const std::string& roomName, const Room* room)>;
+    void setChangeObserver(ChangeObserver observer);
+
+    // Every change stamps the room with the next table version, so a stamp is never
+    // reused even when a room is deleted and created again. Code that changes a
+    // room in place calls markModified() before saveRooms().
+    void markModified(Room& room);
+    std::uint64_t getVersion() const;
+    std::uint64_t getRoomVersion(const std::string& roomName); // 0 when the room does not exist
+
+    // Deferred persistence: inside a batch saveRooms() and history appends only mark
+    // work as pending, and the outermost endBatch() writes rooms.txt and the log once
+    void beginBatch();
+    void endBatch();
 
 private:
     std::vector<Room> rooms;
+    std::unordered_map<std::string, std::size_t> roomIndex; // name -> position in rooms
+    // Atomic so rooms can be changed in place from several threads (offline replay);
+    // adding or removing rooms still needs exclusive access
+    std::atomic<std::uint64_t> tableVersion;
+    int batchDepth;
+    std::atomic<bool> saveDeferred;
     const std::string ROOMS_FILE = "output/rooms.txt";
     RoomHistoryManager* historyManager;
+    ChangeObserver changeObserver;
+
+    void rebuildIndex();
 };
 
 #endif // ROOM_HPP
\ No newline at end of file
@@ -0,0 +1,53 @@
+#ifndef SESSION_HPP
+#define SESSION_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Opaque session tokens handed out after a successful login. Tokens are spread
+// over independently locked shards so validation is an O(1) lookup that only
+// contends with writers on the same shard.
+class SessionStore {
+public:
+    struct Session {
+        std::string username;
+        int role; // Authentication::Role stored as int to keep this header free of auth.hpp
+        std::chrono::steady_clock::time_point expiresAt;
+    };
+
+    explicit SessionStore(std::chrono::seconds ttl = std::chrono::hours(8));
+
+    std::string issue(const std::string& username, int role);
+    bool validate(const std::string& token, Session& session);
+    void revoke(const std::string& token);
+    void revokeUser(const std::string& username);
+    std::size_t purgeExpired();
+
+    void setTimeToLive(std::chrono::seconds ttl);
+
+private:
+    static const std::size_t SHARD_COUNT = 16;
+
+    struct Shard {
+        std::shared_mutex mutex;
+        std::unordered_map<std::string, Session> sessions;
+    };
+
+    Shard shards[SHARD_COUNT];
+    std::chrono::seconds timeToLive;
+
+    // username -> tokens, so revocation does not have to scan every shard
+    std::mutex userIndexMutex;
+    std::unordered_map<std::string, std::unordered_set<std::string>> tokensByUser;
+
+    Shard& shardFor(const std::string& token);
+    static std::string generateToken();
+};
+
+#endif // SESSION_HPP
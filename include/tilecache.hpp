@@ -0,0 +1,62 @@
+#ifndef TILECACHE_HPP
+#define TILECACHE_HPP
+
+#include "raylib.h"
+#include "room.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Floor-plan room tiles rendered once into slots of a shared RenderTexture
+// atlas. A slot is re-rendered only when its room's version stamp changes, so
+// a steady frame just copies textures instead of rasterizing text. Slots not
+// used in the current frame are handed to other rooms, least recently used
+// first.
+//
+// Rendering into the atlas switches the framebuffer, so prepare() has to be
+// called outside any scissor region, before the tiles are drawn.
+class TileCache {
+public:
+    TileCache(int tileWidth, int tileHeight, int atlasWidth = 2048, int atlasHeight = 1024);
+
+    // Advances the frame used to decide which slots are free to reuse
+    void beginFrame();
+    // Makes sure the room's slot holds its current version; false when every
+    // slot is already taken this frame and the tile has to be drawn directly
+    bool prepare(const Room& room);
+    // Draws the room's tile, from the atlas when prepare() accepted it
+    void draw(const Room& room, float x, float y);
+    // Frees the atlas; call before the window is closed
+    void unload();
+
+    // Tiles rendered into the atlas since startup, for checking the hit rate
+    std::uint64_t getRenderCount() const;
+
+    // The tile itself, as drawn into a slot or straight to the screen
+    static void drawTile(const Room& room, float x, float y, float width, float height);
+
+private:
+    struct Slot {
+        std::string room; // Empty while unused
+        std::uint64_t version = 0;
+        std::uint64_t lastFrame = 0;
+    };
+
+    int tileWidth;
+    int tileHeight;
+    int atlasWidth;
+    int atlasHeight;
+    int columns;
+    RenderTexture2D atlas;
+    bool loaded;
+    std::vector<Slot> slots;
+    std::unordered_map<std::string, std::size_t> slotOfRoom;
+    std::uint64_t frame;
+    std::uint64_t renderCount;
+
+    Rectangle slotRect(std::size_t slot) const;
+};
+
+#endif // TILECACHE_HPP
@@ -0,0 +1,54 @@
+#ifndef USERDIRECTORY_HPP
+#define USERDIRECTORY_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+// Username index kept sorted alongside the credential map, so the admin user
+// list can be searched by prefix, filtered by role and paged without copying
+// or sorting the whole user set. Each role also has its own sorted array, so a
+// filtered page is a contiguous range as well.
+class UserDirectory {
+public:
+    static const int ANY_ROLE = -1;
+
+    struct Entry {
+        std::string username;
+        int role; // Authentication::Role stored as int to keep this header free of auth.hpp
+    };
+
+    // View into the directory; invalidated by the next mutation
+    struct Page {
+        const Entry* first = nullptr;
+        const Entry* last = nullptr;
+        std::size_t offset = 0;
+        std::size_t totalMatches = 0;
+
+        const Entry* begin() const { return first; }
+        const Entry* end() const { return last; }
+        std::size_t size() const { return last - first; }
+        bool empty() const { return first == last; }
+    };
+
+    void rebuild(std::vector<Entry> entries);
+    void put(const std::string& username, int role);
+    void remove(const std::string& username);
+
+    Page query(const std::string& prefix, int role, std::size_t offset, std::size_t limit) const;
+    std::size_t size() const;
+    // Bumped on every mutation so callers can tell when cached pages are stale
+    std::uint64_t getVersion() const;
+
+private:
+    std::vector<Entry> all;
+    std::map<int, std::vector<Entry>> byRole;
+    std::uint64_t version = 0;
+
+    static void insertSorted(std::vector<Entry>& entries, const Entry& entry);
+    static bool eraseSorted(std::vector<Entry>& entries, const std::string& username);
+};
+
+#endif // USERDIRECTORY_HPP
@@ -0,0 +1,42 @@
+#ifndef VIRTUALLIST_HPP
+#define VIRTUALLIST_HPP
+
+#include "raylib.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Scrollable list of text rows for the GUI popups. Each row is measured once,
+// when it is added, and only the rows inside the view are drawn, so a long list
+// costs the same per frame as a short one.
+class VirtualList {
+public:
+    explicit VirtualList(float rowHeight = 25, int fontSize = 15);
+
+    // Drops every row and scrolls back to the top
+    void clear();
+    void append(const std::string& row);
+    // Keeps the list in step with a source that usually only grows at the end,
+    // such as the offline queue. Nothing happens while the version is unchanged;
+    // when the rows already shown are still at the start of the source only the
+    // new ones are added, otherwise the list is rebuilt.
+    void sync(const std::vector<std::string>& source, std::uint64_t version);
+
+    // Scroll panel plus the visible rows
+    void draw(Rectangle view, Color color = DARKGRAY);
+
+    std::size_t size() const;
+    bool empty() const;
+
+private:
+    float rowHeight;
+    int fontSize;
+    std::vector<std::string> rows;
+    float maxWidth;
+    Vector2 scroll;
+    std::uint64_t syncedVersion;
+    bool synced;
+};
+
+#endif // VIRTUALLIST_HPP
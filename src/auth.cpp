@@ -2,83 +2,297 @@
 
 #include "auth.hpp"
 #include "ui.hpp"
+#include "durability.hpp"
+#include "passwordhash.hpp"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
 #include <fstream>
-#include <functional>
+#include <sstream>
+#include <unordered_set>
 
-Authentication::Authentication() {
+namespace {
+
+std::string trimField(const std::string& field) {
+    std::size_t begin = 0;
+    std::size_t end = field.size();
+    while (begin < end && std::isspace(static_cast<unsigned char>(field[begin]))) begin++;
+    while (end > begin && std::isspace(static_cast<unsigned char>(field[end - 1]))) end--;
+    return field.substr(begin, end - begin);
+}
+
+// Tab-separated when the row contains a tab, comma-separated otherwise
+std::vector<std::string> splitImportRow(const std::string& line) {
+    char delimiter = line.find('\t') != std::string::npos ? '\t' : ',';
+    std::vector<std::string> fields;
+    std::size_t start = 0;
+    while (true) {
+        std::size_t next = line.find(delimiter, start);
+        fields.push_back(trimField(line.substr(start, next - start)));
+        if (next == std::string::npos) break;
+        start = next + 1;
+    }
+    return fields;
+}
+
+bool equalsIgnoreCase(const std::string& a, const char* b) {
+    std::size_t i = 0;
+    for (; i < a.size() && b[i] != '\0'; ++i) {
+        if (std::tolower(static_cast<unsigned char>(a[i])) != std::tolower(static_cast<unsigned char>(b[i]))) {
+            return false;
+        }
+    }
+    return i == a.size() && b[i] == '\0';
+}
+
+double elapsedMs(std::chrono::steady_clock::time_point since) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - since).count();
+}
+
+} // namespace
+
+Authentication::Authentication()
+    : journalEntries(0), userTableVersion(0), batchDepth(0), pendingJournalEntries(0), compactionRunning(false),
+      userHashCost(PasswordHasher::DEFAULT_COST), adminHashCost(PasswordHasher::DEFAULT_COST + 1) {
     load_users();
 }
 
-std::size_t Authentication::hash_password(const std::string& password) {
-    return std::hash<std::string>{}(password);
+Authentication::~Authentication() {
+    if (compactionThread.joinable()) {
+        compactionThread.join();
+    }
+}
+
+std::string Authentication::hash_password(const std::string& password, Role role) {
+    return PasswordHasher::hash(password, getHashCost(role));
+}
+
+void Authentication::setHashCost(Role role, int cost) {
+    if (role == Role::ADMIN) {
+        adminHashCost = cost;
+    } else {
+        userHashCost = cost;
+    }
+}
+
+int Authentication::getHashCost(Role role) const {
+    return role == Role::ADMIN ? adminHashCost : userHashCost;
 }
 
 void Authentication::load_users() {
     users.clear();
-    std::ifstream users_file(HASHED_USERS_FILE);
-    if (users_file.is_open()) {
-        std::string username;
-        std::size_t hashed_password;
-        while (users_file >> username >> hashed_password) {
-            users[username] = {hashed_password, Role::USER};
-        }
-        users_file.close();
+    load_checkpoint(HASHED_USERS_FILE, Role::USER);
+    load_checkpoint(HASHED_ADMINS_FILE, Role::ADMIN);
+
+    // A leftover compacting journal means the last checkpoint may not have been written
+    replay_journal(USERS_JOURNAL_COMPACTING_FILE);
+    journalEntries = replay_journal(USERS_JOURNAL_FILE);
+
+    // Ensure super admin is always present
+    if (!users.contains("Admin")) {
+        Credential admin{hash_password("123", Role::ADMIN), Role::ADMIN, ++userTableVersion};
+        users.put("Admin", admin);
+        journal_put("Admin", admin);
     }
 
-    std::ifstream admins_file(HASHED_ADMINS_FILE);
-    if (admins_file.is_open()) {
+    rebuild_directory();
+}
+
+// Lines are "<username> <hash> [<version>]"; the version was added later and is optional
+void Authentication::load_checkpoint(const std::string& path, Role role) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        return;
+    }
+    std::string line;
+    while (std::getline(file, line)) {
+        std::stringstream ss(line);
+        Credential credential{"", role};
         std::string username;
-        std::size_t hashed_password;
-        while (admins_file >> username >> hashed_password) {
-            users[username] = {hashed_password, Role::ADMIN};
+        if (ss >> username >> credential.passwordHash) {
+            stamp_loaded(credential, static_cast<bool>(ss >> credential.version));
+            users.put(username, credential);
         }
-        admins_file.close();
     }
+}
 
-    // Ensure super admin is always present
-    if (users.find("Admin") == users.end()) {
-        users["Admin"] = {hash_password("123"), Role::ADMIN};
-        save_users();
+// Records written before versions existed get a fresh stamp
+void Authentication::stamp_loaded(Credential& credential, bool hasVersion) {
+    if (hasVersion) {
+        userTableVersion = std::max(userTableVersion, credential.version);
+    } else {
+        credential.version = ++userTableVersion;
     }
 }
 
-void Authentication::save_users() {
-    std::ofstream users_file(HASHED_USERS_FILE);
-    std::ofstream admins_file(HASHED_ADMINS_FILE);
-    if (users_file.is_open() && admins_file.is_open()) {
-        for (const auto& user : users) {
-            if (user.second.second == Role::USER) {
-                users_file << user.first << " " << user.second.first << std::endl;
-            } else {
-                admins_file << user.first << " " << user.second.first << std::endl;
+void Authentication::rebuild_directory() {
+    std::vector<UserDirectory::Entry> entries;
+    entries.reserve(users.size());
+    users.forEach([&entries](const std::string& username, const Credential& credential) {
+        entries.push_back({username, static_cast<int>(credential.role)});
+    });
+    directory.rebuild(std::move(entries));
+}
+
+// Lines are "PUT <username> <USER|ADMIN> <hash> <version>" or "DEL <username>".
+// Each one carries the full record, so replaying a line twice is harmless.
+std::size_t Authentication::replay_journal(const std::string& path) {
+    std::ifstream journal(path);
+    if (!journal.is_open()) {
+        return 0;
+    }
+    std::size_t applied = 0;
+    std::string line;
+    while (std::getline(journal, line)) {
+        std::stringstream ss(line);
+        std::string op, username;
+        if (!(ss >> op >> username)) {
+            continue; // Torn write at the tail
+        }
+        if (op == "PUT") {
+            std::string role;
+            Credential credential;
+            if (ss >> role >> credential.passwordHash) {
+                credential.role = role == "ADMIN" ? Role::ADMIN : Role::USER;
+                stamp_loaded(credential, static_cast<bool>(ss >> credential.version));
+                users.put(username, credential);
+                applied++;
             }
+        } else if (op == "DEL") {
+            users.erase(username);
+            userTableVersion++;
+            applied++;
         }
-        users_file.close();
-        admins_file.close();
     }
+    return applied;
 }
 
-bool Authentication::registerUser(const std::string& username, const std::string& password) {
-    if (users.find(username) != users.end()) {
-        UI::displayMessage("Username already exists.");
-        return false;
+// Callers hold mutationMutex, so journal order matches the order of the changes
+void Authentication::journal_put(const std::string& username, const Credential& credential) {
+    journal_append("PUT " + username + " " + (credential.role == Role::ADMIN ? "ADMIN" : "USER") + " " + credential.passwordHash + " " +
+                   std::to_string(credential.version) + "\n", 1);
+}
+
+void Authentication::journal_delete(const std::string& username) {
+    journal_append("DEL " + username + "\n", 1);
+}
+
+void Authentication::journal_append(const std::string& lines, std::size_t entries) {
+    if (batchDepth > 0) {
+        pendingJournal += lines;
+        pendingJournalEntries += entries;
+        return;
+    }
+    if (!Durability::append(USERS_JOURNAL_FILE, lines)) {
+        UI::displayMessage("Error: Unable to save user accounts.");
+        return;
+    }
+    journalEntries += entries;
+    // Inside a transaction the append is not on disk yet, so the journal is rotated on a later change
+    if (journalEntries >= JOURNAL_COMPACTION_THRESHOLD && !Durability::inTransaction()) {
+        start_compaction();
     }
+}
 
-    std::size_t hashed_password = hash_password(password);
-    users[username] = {hashed_password, Role::USER};
-    save_users();
-    return true;
+void Authentication::beginBatch() {
+    std::lock_guard<std::mutex> lock(mutationMutex);
+    batchDepth++;
+}
+
+void Authentication::endBatch() {
+    std::lock_guard<std::mutex> lock(mutationMutex);
+    if (batchDepth == 0 || --batchDepth > 0 || pendingJournal.empty()) {
+        return;
+    }
+    std::string lines;
+    lines.swap(pendingJournal);
+    std::size_t entries = pendingJournalEntries;
+    pendingJournalEntries = 0;
+    journal_append(lines, entries);
+}
+
+// Rotates the journal and writes a fresh checkpoint from a snapshot on a
+// background thread. Recovery replays checkpoint + compacting journal + journal,
+// so a crash at any point leaves a consistent view.
+void Authentication::start_compaction() {
+    if (compactionRunning) {
+        return; // Still writing the previous checkpoint; try again on a later change
+    }
+    if (compactionThread.joinable()) {
+        compactionThread.join();
+    }
+    std::error_code ec;
+    if (std::filesystem::exists(USERS_JOURNAL_COMPACTING_FILE, ec)) {
+        // The previous checkpoint failed; fold the new entries into the pending journal
+        std::ifstream journal(USERS_JOURNAL_FILE, std::ios::binary);
+        std::stringstream pending;
+        pending << journal.rdbuf();
+        journal.close();
+        if (!Durability::append(USERS_JOURNAL_COMPACTING_FILE, pending.str())) {
+            return;
+        }
+        std::filesystem::remove(USERS_JOURNAL_FILE, ec);
+    } else {
+        std::filesystem::rename(USERS_JOURNAL_FILE, USERS_JOURNAL_COMPACTING_FILE, ec);
+        if (ec) {
+            return;
+        }
+    }
+    journalEntries = 0;
+
+    compactionRunning = true;
+    compactionThread = std::thread([this, snapshot = users.snapshot()]() {
+        if (save_users(snapshot)) {
+            std::remove(USERS_JOURNAL_COMPACTING_FILE.c_str());
+        }
+        compactionRunning = false;
+    });
+}
+
+bool Authentication::save_users(const std::unordered_map<std::string, Credential>& snapshot) const {
+    std::ostringstream users_out;
+    std::ostringstream admins_out;
+    for (const auto& user : snapshot) {
+        if (user.second.role == Role::USER) {
+            users_out << user.first << " " << user.second.passwordHash << " " << user.second.version << "\n";
+        } else {
+            admins_out << user.first << " " << user.second.passwordHash << " " << user.second.version << "\n";
+        }
+    }
+    return Durability::writeFile(HASHED_USERS_FILE, users_out.str()) &&
+           Durability::writeFile(HASHED_ADMINS_FILE, admins_out.str());
+}
+
+bool Authentication::registerUser(const std::string& username, const std::string& password) {
+    return register_account(username, password, Role::USER);
 }
 
 bool Authentication::registerAdmin(const std::string& username, const std::string& password) {
-    if (users.find(username) != users.end()) {
+    return register_account(username, password, Role::ADMIN);
+}
+
+bool Authentication::register_account(const std::string& username, const std::string& password, Role role) {
+    if (users.contains(username)) {
         UI::displayMessage("Username already exists.");
         return false;
     }
 
-    std::size_t hashed_password = hash_password(password);
-    users[username] = {hashed_password, Role::ADMIN};
-    save_users();
+    return completeRegister(username, hash_password(password, role), role);
+}
+
+bool Authentication::completeRegister(const std::string& username, const std::string& passwordHash, Role role) {
+    Credential credential{passwordHash, role};
+    std::lock_guard<std::mutex> lock(mutationMutex);
+    credential.version = userTableVersion + 1;
+    if (!users.insert(username, credential)) {
+        UI::displayMessage("Username already exists."); // Registered by another thread while hashing
+        return false;
+    }
+    userTableVersion++;
+    directory.put(username, static_cast<int>(role));
+    journal_put(username, credential);
     return true;
 }
 
@@ -90,15 +304,72 @@ bool Authentication::login(const std::string& username, const std::string& passw
 }
 
 bool Authentication::loginUser(const std::string& username, const std::string& password, Role& role) {
-    auto it = users.find(username);
-    if (it != users.end()) {
-        std::size_t hashed_password = hash_password(password);
-        if (it->second.first == hashed_password) {
-            role = it->second.second;
-            return true; // Login successful
+    Credential credential;
+    if (!users.find(username, credential)) {
+        return false; // Invalid username or password
+    }
+    LoginResult result = verifyCredential(password, credential, getHashCost(credential.role));
+    return completeLogin(username, result, role);
+}
+
+Authentication::LoginResult Authentication::verifyCredential(const std::string& password, const Credential& credential, int targetCost) {
+    LoginResult result;
+    result.verifiedHash = credential.passwordHash;
+    if (PasswordHasher::verify(password, credential.passwordHash)) {
+        result.success = true;
+        result.role = credential.role;
+        // The plaintext is only available now, so legacy and low-cost hashes are upgraded here
+        if (PasswordHasher::needsRehash(credential.passwordHash, targetCost)) {
+            result.upgradedHash = PasswordHasher::hash(password, targetCost);
         }
     }
-    return false; // Invalid username or password
+    return result;
+}
+
+std::future<Authentication::LoginResult> Authentication::loginUserAsync(const std::string& username, const std::string& password) {
+    // The worker gets its own copy of the record, so it never touches the user map
+    Credential credential;
+    if (!users.find(username, credential)) {
+        std::promise<LoginResult> rejected;
+        rejected.set_value(LoginResult{});
+        return rejected.get_future();
+    }
+    int targetCost = getHashCost(credential.role);
+    return verifyPool.submit([password, credential, targetCost]() {
+        return verifyCredential(password, credential, targetCost);
+    });
+}
+
+std::future<std::string> Authentication::hashPasswordAsync(const std::string& password, Role role) {
+    int cost = getHashCost(role);
+    return verifyPool.submit([password, cost]() {
+        return PasswordHasher::hash(password, cost);
+    });
+}
+
+bool Authentication::completeLogin(const std::string& username, const LoginResult& result, Role& role) {
+    if (!result.success) {
+        return false;
+    }
+    Credential credential;
+    if (!users.find(username, credential) || credential.passwordHash != result.verifiedHash) {
+        return false; // Deleted or re-keyed while the verification was running
+    }
+    if (!result.upgradedHash.empty()) {
+        std::lock_guard<std::mutex> lock(mutationMutex);
+        // Compare-and-swap on the hash, so a concurrent edit is never overwritten
+        bool upgraded = users.update(username, [&](Credential& stored) {
+            if (stored.passwordHash != result.verifiedHash) return false;
+            stored.passwordHash = result.upgradedHash;
+            credential = stored;
+            return true;
+        });
+        if (upgraded) {
+            journal_put(username, credential);
+        }
+    }
+    role = credential.role;
+    return true;
 }
 
 bool Authentication::deleteUser(const std::string& usernameToDelete) {
@@ -107,10 +378,12 @@ bool Authentication::deleteUser(const std::string& usernameToDelete) {
         return false;
     }
 
-    auto it = users.find(usernameToDelete);
-    if (it != users.end()) {
-        users.erase(it);
-        save_users();
+    std::lock_guard<std::mutex> lock(mutationMutex);
+    if (users.erase(usernameToDelete)) {
+        userTableVersion++;
+        directory.remove(usernameToDelete);
+        sessions.revokeUser(usernameToDelete);
+        journal_delete(usernameToDelete);
         UI::displayMessage("User/Admin '" + usernameToDelete + "' deleted successfully.");
         return true;
     } else {
@@ -125,11 +398,31 @@ bool Authentication::editUser(const std::string& usernameToEdit, const std::stri
         return false;
     }
 
-    auto it = users.find(usernameToEdit);
-    if (it != users.end()) {
-        it->second.first = hash_password(newPassword);
-        it->second.second = newRole;
-        save_users();
+    if (!users.contains(usernameToEdit)) {
+        UI::displayMessage("Error: User/Admin '" + usernameToEdit + "' not found.");
+        return false;
+    }
+
+    return completeEditUser(usernameToEdit, hash_password(newPassword, newRole), newRole);
+}
+
+bool Authentication::completeEditUser(const std::string& usernameToEdit, const std::string& passwordHash, Role newRole) {
+    if (usernameToEdit == "Chetan") {
+        UI::displayMessage("Error: Cannot edit superadmin 'Chetan'.");
+        return false;
+    }
+
+    Credential credential{passwordHash, newRole};
+    std::lock_guard<std::mutex> lock(mutationMutex);
+    credential.version = ++userTableVersion;
+    bool updated = users.update(usernameToEdit, [&credential](Credential& stored) {
+        stored = credential;
+        return true;
+    });
+    if (updated) {
+        directory.put(usernameToEdit, static_cast<int>(newRole));
+        sessions.revokeUser(usernameToEdit);
+        journal_put(usernameToEdit, credential);
         UI::displayMessage("User/Admin '" + usernameToEdit + "' updated successfully.");
         return true;
     } else {
@@ -138,10 +431,218 @@ bool Authentication::editUser(const std::string& usernameToEdit, const std::stri
     }
 }
 
+bool Authentication::importUsers(const std::string& path, ImportReport& report) {
+    PreparedImport prepared = prepare_import(path, getHashCost(Role::USER), getHashCost(Role::ADMIN), nullptr);
+    return completeImport(prepared, report);
+}
+
+std::future<Authentication::PreparedImport> Authentication::importUsersAsync(const std::string& path, ImportProgress* progress) {
+    // Not on verifyPool: the import waits on its own hashing pool and would hold a login worker meanwhile
+    int userCost = getHashCost(Role::USER);
+    int adminCost = getHashCost(Role::ADMIN);
+    if (progress) {
+        progress->rowsRead = 0;
+        progress->accepted = 0;
+        progress->hashed = 0;
+    }
+    return std::async(std::launch::async, [this, path, userCost, adminCost, progress]() {
+        return prepare_import(path, userCost, adminCost, progress);
+    });
+}
+
+Authentication::PreparedImport Authentication::prepare_import(const std::string& path, int userCost, int adminCost, ImportProgress* progress) const {
+    PreparedImport prepared;
+    prepared.started = std::chrono::steady_clock::now();
+    ImportReport& report = prepared.report;
+    std::vector<PreparedImport::Row>& pending = prepared.rows;
+
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        UI::displayMessage("Error: Unable to open import file '" + path + "'.");
+        return prepared;
+    }
+    prepared.opened = true;
+
+    std::unordered_set<std::string> seen; // Usernames accepted earlier in this file
+
+    // Single pass: validate each row and check it against both the store and the file
+    std::string line;
+    std::size_t lineNumber = 0;
+    while (std::getline(file, line)) {
+        lineNumber++;
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (trimField(line).empty() || line[0] == '#') {
+            continue;
+        }
+        std::vector<std::string> fields = splitImportRow(line);
+        if (report.rowsRead == 0 && pending.empty() && equalsIgnoreCase(fields[0], "username")) {
+            continue; // Header row
+        }
+        report.rowsRead++;
+        if (progress) progress->rowsRead = report.rowsRead;
+
+        if (fields.size() < 2 || fields.size() > 3) {
+            report.errors.push_back({lineNumber, "expected username,password[,role]"});
+            continue;
+        }
+        const std::string& username = fields[0];
+        const std::string& password = fields[1];
+        if (username.empty() || std::any_of(username.begin(), username.end(), [](unsigned char c) { return std::isspace(c); })) {
+            report.errors.push_back({lineNumber, "username must be non-empty and contain no whitespace"});
+            continue;
+        }
+        if (password.empty()) {
+            report.errors.push_back({lineNumber, "password is empty"});
+            continue;
+        }
+        Role role = Role::USER;
+        if (fields.size() == 3 && !fields[2].empty()) {
+            if (equalsIgnoreCase(fields[2], "admin")) {
+                role = Role::ADMIN;
+            } else if (!equalsIgnoreCase(fields[2], "user")) {
+                report.errors.push_back({lineNumber, "unknown role '" + fields[2] + "'"});
+                continue;
+            }
+        }
+        if (users.contains(username)) {
+            report.errors.push_back({lineNumber, "username '" + username + "' already exists"});
+            continue;
+        }
+        if (!seen.insert(username).second) {
+            report.errors.push_back({lineNumber, "username '" + username + "' is duplicated in the file"});
+            continue;
+        }
+        pending.push_back({lineNumber, username, password, role, ""});
+        if (progress) progress->accepted = pending.size();
+    }
+    file.close();
+    report.parseMs = elapsedMs(prepared.started);
+
+    // Hash on a dedicated pool so a large import does not starve interactive logins
+    auto hashStart = std::chrono::steady_clock::now();
+    if (!pending.empty()) {
+        ThreadPool pool(std::min(ThreadPool::defaultThreadCount(), pending.size()));
+        std::size_t chunkCount = std::min(pending.size(), pool.size() * 4);
+        std::size_t chunkSize = (pending.size() + chunkCount - 1) / chunkCount;
+        std::vector<std::future<void>> chunks;
+        for (std::size_t begin = 0; begin < pending.size(); begin += chunkSize) {
+            std::size_t end = std::min(begin + chunkSize, pending.size());
+            chunks.push_back(pool.submit([&pending, begin, end, userCost, adminCost, progress]() {
+                for (std::size_t i = begin; i < end; ++i) {
+                    PreparedImport::Row& user = pending[i];
+                    user.passwordHash = PasswordHasher::hash(user.password, user.role == Role::ADMIN ? adminCost : userCost);
+                    user.password.clear();
+                    if (progress) progress->hashed++;
+                }
+            }));
+        }
+        for (auto& chunk : chunks) chunk.get();
+    }
+    report.hashMs = elapsedMs(hashStart);
+
+    return prepared;
+}
+
+bool Authentication::completeImport(PreparedImport& prepared, ImportReport& report) {
+    report = std::move(prepared.report);
+    if (!prepared.opened) {
+        return false;
+    }
+    const std::vector<PreparedImport::Row>& pending = prepared.rows;
+
+    // Apply in memory, then persist every new account with a single journal append
+    auto persistStart = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> lock(mutationMutex);
+    std::vector<const PreparedImport::Row*> inserted;
+    std::string journal;
+    for (const auto& user : pending) {
+        if (!users.insert(user.username, {user.passwordHash, user.role, userTableVersion + 1})) {
+            report.errors.push_back({user.line, "username '" + user.username + "' was registered while the import was running"});
+            continue;
+        }
+        userTableVersion++;
+        inserted.push_back(&user);
+        journal += "PUT " + user.username + " " + (user.role == Role::ADMIN ? "ADMIN" : "USER") + " " + user.passwordHash + " " +
+                   std::to_string(userTableVersion) + "\n";
+    }
+    bool saved = true;
+    if (!journal.empty()) {
+        saved = Durability::append(USERS_JOURNAL_FILE, journal);
+        if (!saved) {
+            for (const auto* user : inserted) users.erase(user->username);
+            inserted.clear();
+            UI::displayMessage("Error: Unable to save user accounts.");
+        } else {
+            // Re-sorting once is cheaper than a sorted insert per imported row
+            rebuild_directory();
+            journalEntries += inserted.size();
+            if (journalEntries >= JOURNAL_COMPACTION_THRESHOLD) {
+                start_compaction();
+            }
+        }
+    }
+    report.imported = inserted.size();
+    report.persistMs = elapsedMs(persistStart);
+    report.totalMs = elapsedMs(prepared.started);
+    return saved;
+}
+
+std::string Authentication::startSession(const std::string& username) {
+    Credential credential;
+    if (!users.find(username, credential)) {
+        return "";
+    }
+    return sessions.issue(username, static_cast<int>(credential.role));
+}
+
+bool Authentication::validateSession(const std::string& token, std::string& username, Role& role) {
+    SessionStore::Session session;
+    if (!sessions.validate(token, session)) {
+        return false;
+    }
+    username = session.username;
+    role = static_cast<Role>(session.role);
+    return true;
+}
+
+void Authentication::endSession(const std::string& token) {
+    sessions.revoke(token);
+}
+
+bool Authentication::hasUser(const std::string& username) const {
+    return users.contains(username);
+}
+
+std::uint64_t Authentication::getUserVersion(const std::string& username) const {
+    Credential credential;
+    return users.find(username, credential) ? credential.version : 0;
+}
+
+bool Authentication::getUserRole(const std::string& username, Role& role) const {
+    Credential credential;
+    if (!users.find(username, credential)) {
+        return false;
+    }
+    role = credential.role;
+    return true;
+}
+
 std::vector<std::pair<std::string, Authentication::Role>> Authentication::getUsersAndAdmins() const {
+    std::lock_guard<std::mutex> lock(mutationMutex);
     std::vector<std::pair<std::string, Role>> list;
-    for (const auto& pair : users) {
-        list.push_back({pair.first, pair.second.second});
+    list.reserve(directory.size());
+    for (const auto& entry : directory.query("", UserDirectory::ANY_ROLE, 0, directory.size())) {
+        list.push_back({entry.username, static_cast<Role>(entry.role)});
     }
     return list;
 }
+
+UserDirectory::Page Authentication::queryUsers(const std::string& prefix, int role, std::size_t offset, std::size_t limit) const {
+    std::lock_guard<std::mutex> lock(mutationMutex);
+    return directory.query(prefix, role, offset, limit);
+}
+
+std::uint64_t Authentication::getDirectoryVersion() const {
+    std::lock_guard<std::mutex> lock(mutationMutex);
+    return directory.getVersion();
+}
@@ -0,0 +1,109 @@
+#include "compression.hpp"
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+const std::size_t MIN_MATCH = 4;
+const std::size_t MAX_OFFSET = 65535;
+const int HASH_BITS = 16;
+
+std::uint32_t hashAt(const char* data) {
+    std::uint32_t value;
+    std::memcpy(&value, data, sizeof(value));
+    return (value * 2654435761u) >> (32 - HASH_BITS);
+}
+
+// Lengths of 15 and more continue in 255-valued bytes
+void putLength(std::string& out, std::size_t length) {
+    while (length >= 255) {
+        out.push_back(static_cast<char>(255));
+        length -= 255;
+    }
+    out.push_back(static_cast<char>(length));
+}
+
+bool getLength(const std::string& in, std::size_t& pos, std::size_t& length) {
+    std::uint8_t byte;
+    do {
+        if (pos >= in.size()) return false;
+        byte = static_cast<std::uint8_t>(in[pos++]);
+        length += byte;
+    } while (byte == 255);
+    return true;
+}
+
+void putSequence(std::string& out, const char* literals, std::size_t literalCount, std::size_t offset, std::size_t matchLength) {
+    std::size_t matchCode = matchLength == 0 ? 0 : matchLength - MIN_MATCH;
+    std::uint8_t token = static_cast<std::uint8_t>((literalCount < 15 ? literalCount : 15) << 4);
+    token |= static_cast<std::uint8_t>(matchCode < 15 ? matchCode : 15);
+    out.push_back(static_cast<char>(token));
+    if (literalCount >= 15) putLength(out, literalCount - 15);
+    out.append(literals, literalCount);
+    if (matchLength == 0) return; // Last sequence: literals only
+    out.push_back(static_cast<char>(offset & 0xff));
+    out.push_back(static_cast<char>(offset >> 8));
+    if (matchCode >= 15) putLength(out, matchCode - 15);
+}
+
+} // namespace
+
+std::string Compression::compress(const std::string& input) {
+    std::string out;
+    out.reserve(input.size() / 2 + 16);
+    const char* data = input.data();
+    std::size_t size = input.size();
+    std::vector<std::int64_t> table(std::size_t(1) << HASH_BITS, -1);
+    std::size_t anchor = 0;
+    std::size_t pos = 0;
+    while (pos + MIN_MATCH <= size) {
+        std::uint32_t hash = hashAt(data + pos);
+        std::int64_t candidate = table[hash];
+        table[hash] = static_cast<std::int64_t>(pos);
+        if (candidate < 0 || pos - static_cast<std::size_t>(candidate) > MAX_OFFSET ||
+            std::memcmp(data + candidate, data + pos, MIN_MATCH) != 0) {
+            pos++;
+            continue;
+        }
+        std::size_t match = static_cast<std::size_t>(candidate);
+        std::size_t length = MIN_MATCH;
+        while (pos + length < size && data[match + length] == data[pos + length]) {
+            length++;
+        }
+        putSequence(out, data + anchor, pos - anchor, pos - match, length);
+        pos += length;
+        anchor = pos;
+    }
+    putSequence(out, data + anchor, size - anchor, 0, 0);
+    return out;
+}
+
+bool Compression::decompress(const std::string& input, std::size_t originalSize, std::string& output) {
+    output.clear();
+    output.reserve(originalSize);
+    std::size_t pos = 0;
+    while (pos < input.size()) {
+        std::uint8_t token = static_cast<std::uint8_t>(input[pos++]);
+        std::size_t literalCount = token >> 4;
+        if (literalCount == 15 && !getLength(input, pos, literalCount)) return false;
+        if (input.size() - pos < literalCount || originalSize - output.size() < literalCount) return false;
+        output.append(input, pos, literalCount);
+        pos += literalCount;
+        if (pos == input.size()) break;
+
+        if (input.size() - pos < 2) return false;
+        std::size_t offset = static_cast<std::uint8_t>(input[pos]) | (static_cast<std::size_t>(static_cast<std::uint8_t>(input[pos + 1])) << 8);
+        pos += 2;
+        std::size_t length = token & 15;
+        if (length == 15 && !getLength(input, pos, length)) return false;
+        length += MIN_MATCH;
+        if (offset == 0 || offset > output.size() || originalSize - output.size() < length) return false;
+        // Byte by byte, since a match may overlap the bytes it produces
+        std::size_t from = output.size() - offset;
+        for (std::size_t i = 0; i < length; ++i) {
+            output.push_back(output[from + i]);
+        }
+    }
+    return output.size() == originalSize;
+}
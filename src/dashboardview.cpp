@@ -0,0 +1,193 @@
+#include "dashboardview.hpp"
+#include "durability.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+
+namespace {
+
+// Reuses the string's buffer, so a line of about the same length as last frame does not allocate
+void formatInto(std::string& out, const char* format, ...) {
+    char buffer[512];
+    va_list args;
+    va_start(args, format);
+    std::vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    out.assign(buffer);
+}
+
+void toLower(std::string& text) {
+    std::transform(text.begin(), text.end(), text.begin(), [](unsigned char c) { return (char)std::tolower(c); });
+}
+
+std::string formatTime(time_t timestamp) {
+    char buffer[32];
+    struct tm* timeinfo = localtime(&timestamp);
+    strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", timeinfo);
+    return buffer;
+}
+
+} // namespace
+
+DashboardView::DashboardView(RoomManager& rm, OfflineManager& offline)
+    : rm(rm), offline(offline), shownRooms(&rm.getRooms()), dirty(true), filteredAvailable(false), filteredBooked(false),
+      filteredOffline(false), filteredRoomsVersion(0), filteredProjectedVersion(0), filterRuns(0), durabilityFsyncs(0) {}
+
+void DashboardView::updateFloorPlan(const Filter& filter) {
+    bool showingProjection = offline.isOffline();
+    shownRooms = showingProjection ? &offline.getProjectedRooms() : &rm.getRooms();
+    if (filteredSearch != filter.search || filteredCapacity != filter.minCapacity || filteredAvailable != filter.availableOnly ||
+        filteredBooked != filter.bookedOnly || filteredOffline != showingProjection || filteredRoomsVersion != rm.getVersion() ||
+        (showingProjection && filteredProjectedVersion != offline.getProjectedVersion())) {
+        dirty = true;
+    }
+    if (!dirty) {
+        return;
+    }
+    filteredSearch = filter.search;
+    filteredCapacity = filter.minCapacity;
+    filteredAvailable = filter.availableOnly;
+    filteredBooked = filter.bookedOnly;
+    filteredOffline = showingProjection;
+    filteredRoomsVersion = rm.getVersion();
+    filteredProjectedVersion = offline.getProjectedVersion();
+    dirty = false;
+    filterRuns++;
+
+    searchLower = filteredSearch;
+    toLower(searchLower);
+    bool onlyAvailable = filter.availableOnly && !filter.bookedOnly;
+    bool onlyBooked = filter.bookedOnly && !filter.availableOnly;
+    char* end = nullptr;
+    long minCapacity = std::strtol(filter.minCapacity, &end, 10);
+    bool hasMinCapacity = end != filter.minCapacity;
+
+    matches.clear();
+    for (std::size_t i = 0; i < shownRooms->size(); ++i) {
+        const Room& room = (*shownRooms)[i];
+        if (!searchLower.empty()) {
+            nameLower = room.getName();
+            toLower(nameLower);
+            if (nameLower.find(searchLower) == std::string::npos) continue;
+        }
+        if (onlyAvailable && !room.isAvailable()) continue;
+        if (onlyBooked && room.isAvailable()) continue;
+        if (hasMinCapacity && room.getCapacity() < minCapacity) continue;
+        matches.push_back(i);
+    }
+}
+
+void DashboardView::invalidate() {
+    dirty = true;
+}
+
+const std::vector<Room>& DashboardView::getShownRooms() const {
+    return *shownRooms;
+}
+
+std::size_t DashboardView::getMatchCount() const {
+    return matches.size();
+}
+
+int DashboardView::getColumns(const Layout& layout) const {
+    int columns = layout.width > 0 ? (int)(layout.width / (layout.tileWidth + layout.padding)) : 1;
+    return columns > 0 ? columns : 1;
+}
+
+float DashboardView::getContentHeight(const Layout& layout) const {
+    std::size_t columns = getColumns(layout);
+    std::size_t rows = (matches.size() + columns - 1) / columns;
+    return rows * (layout.tileHeight + layout.padding);
+}
+
+const std::vector<DashboardView::Tile>& DashboardView::layoutTiles(const Layout& layout) {
+    tiles.clear();
+    std::size_t columns = getColumns(layout);
+    float rowHeight = layout.tileHeight + layout.padding;
+    std::size_t firstRow = (std::size_t)std::max(0.0f, -layout.scrollY / rowHeight);
+    std::size_t endRow = (std::size_t)std::max(0.0f, (-layout.scrollY + layout.height) / rowHeight) + 1;
+    std::size_t end = std::min(matches.size(), endRow * columns);
+    for (std::size_t i = firstRow * columns; i < end; ++i) {
+        std::size_t row = i / columns;
+        std::size_t column = i % columns;
+        tiles.push_back(Tile{ &(*shownRooms)[matches[i]],
+                              layout.x + column * (layout.tileWidth + layout.padding) + layout.scrollX,
+                              layout.y + row * rowHeight + layout.scrollY });
+    }
+    return tiles;
+}
+
+const DashboardView::Status& DashboardView::updateStatus(const Replicator::Stats* replication) {
+    OfflineManager::SyncProgress syncProgress = offline.getSyncProgress();
+    status.sync.visible = syncProgress.running;
+    if (syncProgress.running) {
+        formatInto(status.sync.text, "Syncing %zu/%zu", syncProgress.applied, syncProgress.total);
+        status.sync.tone = Tone::WARNING;
+    }
+
+    // Durability level and fsync latency; reformatted only after new fsyncs
+    Durability::Metrics durabilityMetrics = Durability::getMetrics();
+    if (!status.durability.visible || durabilityMetrics.fsyncCount != durabilityFsyncs) {
+        status.durability.text = "Durability: " + Durability::describe();
+        if (durabilityMetrics.fsyncCount > 0) {
+            char latency[64];
+            std::snprintf(latency, sizeof(latency), " | fsync avg %.2fms max %.2fms", durabilityMetrics.totalFsyncMs / durabilityMetrics.fsyncCount, durabilityMetrics.maxFsyncMs);
+            status.durability.text += latency;
+        }
+        status.durability.visible = true;
+        durabilityFsyncs = durabilityMetrics.fsyncCount;
+    }
+
+    status.replication.visible = replication != nullptr;
+    if (replication) {
+        formatInto(status.replication.text, "Replication: peer %s | %zu inbound | %zu unacked | %llu sent, %llu applied | %llu B out, %llu B in",
+                   replication->peerConnected ? "connected" : "not connected", replication->inboundPeers, replication->pendingDeltas,
+                   (unsigned long long)replication->deltasSent, (unsigned long long)replication->deltasApplied,
+                   (unsigned long long)replication->bytesSent, (unsigned long long)replication->bytesReceived);
+    }
+
+    // Offline queue depth, memory use and spilled segments
+    OfflineManager::QueueMetrics queueMetrics = offline.getQueueMetrics();
+    status.queue.visible = offline.isOffline() || queueMetrics.queuedOps > 0;
+    if (status.queue.visible) {
+        if (queueMetrics.spilledSegments > 0) {
+            formatInto(status.queue.text, "Queue: %zu ops | mem %zu/%zu KB | spilled %zu in %zu seg (%llu KB)", queueMetrics.queuedOps,
+                       queueMetrics.memoryBytes / 1024, queueMetrics.memoryBudget / 1024, queueMetrics.spilledOps,
+                       queueMetrics.spilledSegments, (unsigned long long)(queueMetrics.spilledBytes / 1024));
+        } else {
+            formatInto(status.queue.text, "Queue: %zu ops | mem %zu/%zu KB", queueMetrics.queuedOps,
+                       queueMetrics.memoryBytes / 1024, queueMetrics.memoryBudget / 1024);
+        }
+        status.queue.tone = queueMetrics.pressure == OfflineManager::QueuePressure::FULL ? Tone::ALERT :
+                            queueMetrics.pressure == OfflineManager::QueuePressure::SPILLING ? Tone::WARNING : Tone::NORMAL;
+    }
+    return status;
+}
+
+std::string DashboardView::formatRoomHistory(const RoomHistoryEntry& entry) {
+    std::string line = formatTime(entry.timestamp) + " | Room: " + entry.roomName + " | Action: " + entry.action + " | By: " + entry.adminName;
+    if (entry.action != "DELETE") {
+        line += " | Capacity: " + std::to_string(entry.capacity) + " | Available: " + (entry.isAvailable ? "Yes" : "No");
+    }
+    return line;
+}
+
+std::string DashboardView::formatBookingHistory(const BookingHistoryEntry& entry) {
+    return formatTime(entry.timestamp) + " | Room: " + entry.roomName + " | User: " + entry.username + " | Action: " + entry.action;
+}
+
+std::string DashboardView::formatAccount(const UserDirectory::Entry& entry) {
+    return entry.username + " (" + (entry.role == (int)Authentication::Role::ADMIN ? "Admin" : "User") + ")";
+}
+
+std::string DashboardView::formatPageText(std::size_t page, std::size_t pageCount, std::size_t total, const char* noun) {
+    return "Page " + std::to_string(pageCount == 0 ? 0 : page + 1) + " of " + std::to_string(pageCount) + " (" + std::to_string(total) + " " + noun + ")";
+}
+
+std::uint64_t DashboardView::getFilterRuns() const {
+    return filterRuns;
+}
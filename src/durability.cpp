@@ -0,0 +1,479 @@
+#include "durability.hpp"
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+struct DurabilityState {
+    std::mutex mutex;
+    std::condition_variable wake;
+    Durability::Level level = Durability::Level::GROUP_COMMIT;
+    int intervalMs = 50;
+    std::set<std::string> dirtyFiles;
+    std::set<std::string> dirtyDirectories;
+    Durability::Metrics metrics;
+    std::thread committer;
+    bool stopCommitter = false;
+
+    ~DurabilityState() {
+        stopCommitterThread();
+    }
+
+    void stopCommitterThread();
+    void startCommitterThread();
+    void commitPending();
+};
+
+DurabilityState& state() {
+    static DurabilityState instance;
+    return instance;
+}
+
+void recordFsync(DurabilityState& s, double ms) {
+    std::lock_guard<std::mutex> lock(s.mutex);
+    s.metrics.fsyncCount++;
+    s.metrics.totalFsyncMs += ms;
+    s.metrics.lastFsyncMs = ms;
+    if (ms > s.metrics.maxFsyncMs) s.metrics.maxFsyncMs = ms;
+}
+
+bool syncStream(FILE* file) {
+    if (std::fflush(file) != 0) return false;
+    auto start = std::chrono::steady_clock::now();
+#ifdef _WIN32
+    bool ok = _commit(_fileno(file)) == 0;
+#else
+    bool ok = fsync(fileno(file)) == 0;
+#endif
+    recordFsync(state(), std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    return ok;
+}
+
+// "rb+" so a file removed since it was marked dirty is not created again
+bool syncPath(const std::string& path) {
+    FILE* file = std::fopen(path.c_str(), "rb+");
+    if (!file) return false;
+    bool ok = syncStream(file);
+    std::fclose(file);
+    return ok;
+}
+
+// Makes a rename durable; a no-op where directories cannot be synced (Windows)
+void syncDirectory(const std::string& directory) {
+#ifndef _WIN32
+    int fd = open(directory.empty() ? "." : directory.c_str(), O_RDONLY);
+    if (fd < 0) return;
+    auto start = std::chrono::steady_clock::now();
+    fsync(fd);
+    recordFsync(state(), std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    close(fd);
+#else
+    (void)directory;
+#endif
+}
+
+std::string parentDirectory(const std::string& path) {
+    return std::filesystem::path(path).parent_path().string();
+}
+
+void DurabilityState::commitPending() {
+    std::set<std::string> files;
+    std::set<std::string> directories;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        files.swap(dirtyFiles);
+        directories.swap(dirtyDirectories);
+        metrics.pendingFiles = 0;
+    }
+    for (const auto& file : files) syncPath(file);
+    for (const auto& directory : directories) syncDirectory(directory);
+}
+
+void DurabilityState::startCommitterThread() {
+    if (committer.joinable()) return;
+    stopCommitter = false;
+    committer = std::thread([this]() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (!stopCommitter) {
+            wake.wait_for(lock, std::chrono::milliseconds(intervalMs));
+            if (dirtyFiles.empty() && dirtyDirectories.empty()) continue;
+            lock.unlock();
+            commitPending();
+            lock.lock();
+        }
+    });
+}
+
+void DurabilityState::stopCommitterThread() {
+    if (!committer.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopCommitter = true;
+    }
+    wake.notify_all();
+    committer.join();
+    commitPending(); // Anything written before shutdown still gets its fsync
+}
+
+void markDirty(DurabilityState& s, const std::string& path, bool renamed) {
+    std::lock_guard<std::mutex> lock(s.mutex);
+    s.dirtyFiles.insert(path);
+    if (renamed) s.dirtyDirectories.insert(parentDirectory(path));
+    s.metrics.pendingFiles = s.dirtyFiles.size();
+}
+
+void ensureCommitter(DurabilityState& s) {
+    std::lock_guard<std::mutex> lock(s.mutex);
+    if (s.level == Durability::Level::GROUP_COMMIT) {
+        s.startCommitterThread();
+    }
+}
+
+const std::string COMMIT_RECORD_FILE = "output/durability_commit.rec";
+
+struct StagedWrite {
+    bool append;
+    std::string path;
+    std::string data;
+    std::uint64_t base; // File size before an append, so finishing it twice still appends once
+};
+
+struct Transaction {
+    int depth = 0;
+    std::vector<StagedWrite> writes;
+};
+
+Transaction& transaction() {
+    thread_local Transaction instance;
+    return instance;
+}
+
+std::uint64_t sizeOf(const std::string& path) {
+    std::error_code ec;
+    std::uintmax_t size = std::filesystem::file_size(path, ec);
+    return ec ? 0 : static_cast<std::uint64_t>(size);
+}
+
+void putInteger(std::string& out, std::uint64_t value, int bytes) {
+    for (int i = 0; i < bytes; ++i) {
+        out += static_cast<char>((value >> (8 * i)) & 0xff);
+    }
+}
+
+bool getInteger(const std::string& in, std::size_t& pos, int bytes, std::uint64_t& value) {
+    if (in.size() - pos < static_cast<std::size_t>(bytes)) return false;
+    value = 0;
+    for (int i = 0; i < bytes; ++i) {
+        value |= static_cast<std::uint64_t>(static_cast<unsigned char>(in[pos + i])) << (8 * i);
+    }
+    pos += bytes;
+    return true;
+}
+
+// FNV-1a over the record body
+std::uint32_t checksum(const char* data, std::size_t size) {
+    std::uint32_t hash = 2166136261u;
+    for (std::size_t i = 0; i < size; ++i) {
+        hash ^= static_cast<unsigned char>(data[i]);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// Per write: kind, path length, path, base, data length, data; then a checksum of it all
+std::string encodeRecord(const std::vector<StagedWrite>& writes) {
+    std::string record;
+    for (const auto& write : writes) {
+        record += write.append ? 'A' : 'W';
+        putInteger(record, write.path.size(), 4);
+        record += write.path;
+        putInteger(record, write.base, 8);
+        putInteger(record, write.data.size(), 8);
+        record += write.data;
+    }
+    putInteger(record, checksum(record.data(), record.size()), 4);
+    return record;
+}
+
+bool decodeRecord(const std::string& record, std::vector<StagedWrite>& writes) {
+    if (record.size() < 4) return false;
+    std::size_t bodySize = record.size() - 4;
+    std::size_t pos = bodySize;
+    std::uint64_t stored;
+    if (!getInteger(record, pos, 4, stored) || stored != checksum(record.data(), bodySize)) return false;
+    pos = 0;
+    while (pos < bodySize) {
+        StagedWrite write;
+        char kind = record[pos++];
+        std::uint64_t pathSize, dataSize;
+        if ((kind != 'A' && kind != 'W') || !getInteger(record, pos, 4, pathSize) || bodySize - pos < pathSize) return false;
+        write.append = kind == 'A';
+        write.path = record.substr(pos, pathSize);
+        pos += pathSize;
+        if (!getInteger(record, pos, 8, write.base) || !getInteger(record, pos, 8, dataSize) || bodySize - pos < dataSize) return false;
+        write.data = record.substr(pos, dataSize);
+        pos += dataSize;
+        writes.push_back(std::move(write));
+    }
+    return true;
+}
+
+// When finishing a record after a crash, an append may already be on disk in
+// full or in part, so the file is cut back to its base first
+bool applyWrites(const std::vector<StagedWrite>& writes, bool finishing) {
+    bool ok = true;
+    for (const auto& write : writes) {
+        if (!write.append) {
+            ok = Durability::writeFile(write.path, write.data) && ok;
+            continue;
+        }
+        if (finishing && sizeOf(write.path) > write.base) {
+            ok = Durability::truncate(write.path, static_cast<std::size_t>(write.base)) && ok;
+        }
+        ok = Durability::append(write.path, write.data) && ok;
+    }
+    return ok;
+}
+
+// The record goes away only once the writes it covers are on disk
+void removeCommitRecord(Durability::Level level) {
+    if (level == Durability::Level::GROUP_COMMIT) {
+        state().commitPending();
+    }
+    std::remove(COMMIT_RECORD_FILE.c_str());
+    if (level != Durability::Level::NONE) {
+        syncDirectory(parentDirectory(COMMIT_RECORD_FILE));
+    }
+}
+
+} // namespace
+
+void Durability::configure(Level level, int groupCommitIntervalMs) {
+    DurabilityState& s = state();
+    s.stopCommitterThread();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    s.level = level;
+    s.intervalMs = groupCommitIntervalMs > 0 ? groupCommitIntervalMs : 50;
+    if (level == Level::GROUP_COMMIT) {
+        s.startCommitterThread();
+    }
+}
+
+void Durability::configureFromEnvironment() {
+    const char* value = std::getenv("IFM_DURABILITY");
+    std::string setting = value ? value : "group";
+    if (setting == "none") {
+        configure(Level::NONE);
+    } else if (setting == "fsync") {
+        configure(Level::PER_OPERATION);
+    } else {
+        int interval = 50;
+        std::size_t colon = setting.find(':');
+        if (colon != std::string::npos) {
+            interval = std::atoi(setting.c_str() + colon + 1);
+        }
+        configure(Level::GROUP_COMMIT, interval);
+    }
+}
+
+Durability::Level Durability::getLevel() {
+    std::lock_guard<std::mutex> lock(state().mutex);
+    return state().level;
+}
+
+int Durability::getGroupCommitInterval() {
+    std::lock_guard<std::mutex> lock(state().mutex);
+    return state().intervalMs;
+}
+
+std::string Durability::describe() {
+    switch (getLevel()) {
+        case Level::NONE:
+            return "none";
+        case Level::PER_OPERATION:
+            return "fsync per op";
+        case Level::GROUP_COMMIT:
+        default:
+            return "group commit " + std::to_string(getGroupCommitInterval()) + "ms";
+    }
+}
+
+bool Durability::writeFile(const std::string& path, const std::string& contents) {
+    Transaction& t = transaction();
+    if (t.depth > 0) {
+        t.writes.push_back({false, path, contents, 0});
+        return true;
+    }
+    DurabilityState& s = state();
+    Level level = getLevel();
+    ensureCommitter(s);
+
+    std::string tempPath = path + ".tmp";
+    FILE* file = std::fopen(tempPath.c_str(), "wb");
+    if (!file) return false;
+    bool ok = std::fwrite(contents.data(), 1, contents.size(), file) == contents.size();
+    if (ok && level == Level::PER_OPERATION) {
+        ok = syncStream(file);
+    }
+    ok = (std::fclose(file) == 0) && ok;
+    if (!ok) {
+        std::remove(tempPath.c_str());
+        return false;
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tempPath, path, ec);
+    if (ec) {
+        std::remove(tempPath.c_str());
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(s.mutex);
+        s.metrics.writes++;
+    }
+    if (level == Level::PER_OPERATION) {
+        syncDirectory(parentDirectory(path));
+    } else if (level == Level::GROUP_COMMIT) {
+        markDirty(s, path, true);
+    }
+    return true;
+}
+
+bool Durability::append(const std::string& path, const std::string& data) {
+    Transaction& t = transaction();
+    if (t.depth > 0) {
+        t.writes.push_back({true, path, data, 0});
+        return true;
+    }
+    DurabilityState& s = state();
+    Level level = getLevel();
+    ensureCommitter(s);
+
+    FILE* file = std::fopen(path.c_str(), "ab");
+    if (!file) return false;
+    bool ok = std::fwrite(data.data(), 1, data.size(), file) == data.size();
+    if (ok && level == Level::PER_OPERATION) {
+        ok = syncStream(file);
+    }
+    ok = (std::fclose(file) == 0) && ok;
+
+    {
+        std::lock_guard<std::mutex> lock(s.mutex);
+        s.metrics.writes++;
+    }
+    if (ok && level == Level::GROUP_COMMIT) {
+        markDirty(s, path, false);
+    }
+    return ok;
+}
+
+bool Durability::truncate(const std::string& path, std::size_t size) {
+    DurabilityState& s = state();
+    Level level = getLevel();
+    ensureCommitter(s);
+
+    std::error_code ec;
+    std::filesystem::resize_file(path, size, ec);
+    if (ec) {
+        return false;
+    }
+    {
+        std::lock_guard<std::mutex> lock(s.mutex);
+        s.metrics.writes++;
+    }
+    if (level == Level::PER_OPERATION) {
+        syncPath(path);
+    } else if (level == Level::GROUP_COMMIT) {
+        markDirty(s, path, false);
+    }
+    return true;
+}
+
+void Durability::flush() {
+    state().commitPending();
+}
+
+void Durability::beginTransaction() {
+    transaction().depth++;
+}
+
+bool Durability::commitTransaction() {
+    Transaction& t = transaction();
+    if (t.depth == 0 || --t.depth > 0) {
+        return true;
+    }
+    std::vector<StagedWrite> writes;
+    writes.swap(t.writes);
+    if (writes.empty()) {
+        return true;
+    }
+
+    // Appends land at the size the file will have by then
+    std::map<std::string, std::uint64_t> sizes;
+    for (auto& write : writes) {
+        auto it = sizes.find(write.path);
+        std::uint64_t size = it != sizes.end() ? it->second : (write.append ? sizeOf(write.path) : 0);
+        write.base = write.append ? size : 0;
+        sizes[write.path] = write.append ? size + write.data.size() : write.data.size();
+    }
+
+    Level level = getLevel();
+    if (!writeFile(COMMIT_RECORD_FILE, encodeRecord(writes))) {
+        return false; // Nothing was applied
+    }
+    if (level == Level::GROUP_COMMIT) {
+        syncPath(COMMIT_RECORD_FILE);
+        syncDirectory(parentDirectory(COMMIT_RECORD_FILE));
+    }
+    // A failed write is reported like one outside a transaction; keeping the
+    // record would let the next start overwrite whatever is written after it
+    bool applied = applyWrites(writes, false);
+    removeCommitRecord(level);
+    return applied;
+}
+
+bool Durability::inTransaction() {
+    return transaction().depth > 0;
+}
+
+bool Durability::recover() {
+    FILE* file = std::fopen(COMMIT_RECORD_FILE.c_str(), "rb");
+    if (!file) {
+        return false;
+    }
+    std::string record;
+    char buffer[65536];
+    std::size_t read;
+    while ((read = std::fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        record.append(buffer, read);
+    }
+    std::fclose(file);
+
+    // The record is replaced atomically, so a damaged one was never committed
+    std::vector<StagedWrite> writes;
+    bool finished = decodeRecord(record, writes) && applyWrites(writes, true);
+    removeCommitRecord(getLevel());
+    return finished;
+}
+
+Durability::Metrics Durability::getMetrics() {
+    std::lock_guard<std::mutex> lock(state().mutex);
+    return state().metrics;
+}
@@ -1,8 +1,10 @@
 
 #include "floorplan.hpp"
 #include "ui.hpp"
+#include "durability.hpp"
 #include <iostream>
 #include <fstream>
+#include <sstream>
 #include <algorithm>
 
 // FloorPlan class implementation
@@ -42,13 +44,11 @@ void FloorPlanManager::loadFloorPlans() {
 }
 
 void FloorPlanManager::saveFloorPlans() {
-    std::ofstream file(FLOOR_PLANS_FILE);
-    if (file.is_open()) {
-        for (const auto& plan : floorPlans) {
-            file << plan.getName() << " " << plan.getLastModifiedBy() << " " << plan.getCapacity() << " " << (plan.isAvailable() ? "Yes" : "No") << std::endl;
-        }
-        file.close();
+    std::ostringstream out;
+    for (const auto& plan : floorPlans) {
+        out << plan.getName() << " " << plan.getLastModifiedBy() << " " << plan.getCapacity() << " " << (plan.isAvailable() ? "Yes" : "No") << "\n";
     }
+    Durability::writeFile(FLOOR_PLANS_FILE, out.str());
 }
 
 void FloorPlanManager::uploadFloorPlan(const std::string& adminName) {
@@ -1,87 +1,416 @@
 #include "history.hpp"
+#include "threadpool.hpp"
+#include "durability.hpp"
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <algorithm>
+
+namespace {
+
+// Reads the whole log in one go so it can be split into chunks without re-reading
+bool readWholeFile(const std::string& path, std::string& buffer) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) return false;
+    std::streamoff size = file.tellg();
+    if (size <= 0) {
+        buffer.clear();
+        return true;
+    }
+    buffer.resize(static_cast<std::size_t>(size));
+    file.seekg(0);
+    file.read(&buffer[0], size);
+    buffer.resize(static_cast<std::size_t>(file.gcount()));
+    return true;
+}
+
+std::size_t fileSize(const std::string& path) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) return 0;
+    std::streamoff size = file.tellg();
+    return size > 0 ? static_cast<std::size_t>(size) : 0;
+}
+
+// Returns the next space-delimited token in [p, end) and advances p past it
+bool nextToken(const char*& p, const char* end, const char*& tokenBegin, const char*& tokenEnd) {
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\r')) ++p;
+    if (p == end) return false;
+    tokenBegin = p;
+    while (p < end && *p != ' ' && *p != '\t' && *p != '\r') ++p;
+    tokenEnd = p;
+    return true;
+}
+
+bool parseInteger(const char* begin, const char* end, long long& value) {
+    bool negative = false;
+    if (begin < end && *begin == '-') {
+        negative = true;
+        ++begin;
+    }
+    if (begin == end) return false;
+    long long result = 0;
+    for (const char* c = begin; c < end; ++c) {
+        if (*c < '0' || *c > '9') return false;
+        result = result * 10 + (*c - '0');
+    }
+    value = negative ? -result : result;
+    return true;
+}
+
+// Format: <timestamp> <action> <roomName> <adminName> <capacity> <Yes|No>
+bool parseRoomHistoryLine(const char* p, const char* end, RoomHistoryEntry& entry) {
+    const char* b;
+    const char* e;
+    long long number;
+    if (!nextToken(p, end, b, e) || !parseInteger(b, e, number)) return false;
+    entry.timestamp = static_cast<time_t>(number);
+    if (!nextToken(p, end, b, e)) return false;
+    entry.action.assign(b, e);
+    if (!nextToken(p, end, b, e)) return false;
+    entry.roomName.assign(b, e);
+    if (!nextToken(p, end, b, e)) return false;
+    entry.adminName.assign(b, e);
+    entry.capacity = -1; // For DELETE actions
+    entry.isAvailable = false;
+    if (nextToken(p, end, b, e) && parseInteger(b, e, number)) {
+        entry.capacity = static_cast<int>(number);
+    }
+    if (nextToken(p, end, b, e)) {
+        entry.isAvailable = (e - b == 3 && b[0] == 'Y' && b[1] == 'e' && b[2] == 's');
+    }
+    return true;
+}
+
+// Format: <timestamp> <action> <roomName> <username>
+bool parseBookingHistoryLine(const char* p, const char* end, BookingHistoryEntry& entry) {
+    const char* b;
+    const char* e;
+    long long number;
+    if (!nextToken(p, end, b, e) || !parseInteger(b, e, number)) return false;
+    entry.timestamp = static_cast<time_t>(number);
+    if (!nextToken(p, end, b, e)) return false;
+    entry.action.assign(b, e);
+    if (!nextToken(p, end, b, e)) return false;
+    entry.roomName.assign(b, e);
+    if (!nextToken(p, end, b, e)) return false;
+    entry.username.assign(b, e);
+    return true;
+}
+
+// Stream-based readers used by getAllHistory() for small logs. The chunked loader
+// falls back to them for lines the tokenizers reject, so a malformed line comes
+// out the same whichever path loads it.
+RoomHistoryEntry readRoomHistoryLine(const std::string& line) {
+    std::stringstream ss(line);
+    RoomHistoryEntry entry{}; // A blank line reads nothing, so it comes out with timestamp 0
+    std::string capacity_str, isAvailable_str;
+
+    ss >> entry.timestamp >> entry.action >> entry.roomName >> entry.adminName >> capacity_str >> isAvailable_str;
+    
+    try {
+        entry.capacity = std::stoi(capacity_str);
+    } catch (...) {
+        entry.capacity = -1; // For DELETE actions
+    }
+    entry.isAvailable = (isAvailable_str == "Yes");
+    return entry;
+}
+
+BookingHistoryEntry readBookingHistoryLine(const std::string& line) {
+    std::stringstream ss(line);
+    BookingHistoryEntry entry{};
+    ss >> entry.timestamp >> entry.action >> entry.roomName >> entry.username;
+    return entry;
+}
+
+// Newline-aligned [begin, end) ranges covering the buffer. A few chunks per thread
+// keeps workers busy when lines are uneven in length.
+std::vector<std::pair<const char*, const char*>> splitIntoChunks(const std::string& buffer, std::size_t threadCount) {
+    std::size_t chunkCount = std::max<std::size_t>(1, std::min(threadCount * 4, buffer.size() / (64 * 1024) + 1));
+    const char* data = buffer.data();
+    const char* dataEnd = data + buffer.size();
+    std::vector<std::pair<const char*, const char*>> chunks;
+    const char* chunkBegin = data;
+    for (std::size_t i = 1; i <= chunkCount && chunkBegin < dataEnd; ++i) {
+        const char* chunkEnd = (i == chunkCount) ? dataEnd : data + buffer.size() * i / chunkCount;
+        if (chunkEnd < chunkBegin) chunkEnd = chunkBegin;
+        chunkEnd = std::find(chunkEnd, dataEnd, '\n');
+        if (chunkEnd != dataEnd) ++chunkEnd;
+        chunks.push_back({chunkBegin, chunkEnd});
+        chunkBegin = chunkEnd;
+    }
+    return chunks;
+}
+
+template <typename Entry, typename Parser, typename Reader>
+void parseChunk(const char* begin, const char* end, Parser parseLine, Reader readLine, std::vector<Entry>& out) {
+    out.reserve(static_cast<std::size_t>(end - begin) / 40);
+    const char* lineBegin = begin;
+    while (lineBegin < end) {
+        const char* lineEnd = std::find(lineBegin, end, '\n');
+        Entry entry;
+        if (parseLine(lineBegin, lineEnd, entry)) {
+            out.push_back(std::move(entry));
+        } else {
+            out.push_back(readLine(std::string(lineBegin, lineEnd)));
+        }
+        lineBegin = lineEnd + 1;
+    }
+}
+
+// Splits the file into newline-aligned chunks, parses them on a pool and joins
+// the per-chunk results in chunk order, which keeps the file order.
+template <typename Entry, typename Parser, typename Reader>
+std::vector<Entry> loadLogParallel(const std::string& path, std::size_t threadCount, Parser parseLine, Reader readLine) {
+    std::vector<Entry> history;
+    std::string buffer;
+    if (!readWholeFile(path, buffer) || buffer.empty()) {
+        return history;
+    }
+
+    if (threadCount == 0) threadCount = ThreadPool::defaultThreadCount();
+    std::vector<std::pair<const char*, const char*>> chunks = splitIntoChunks(buffer, threadCount);
+
+    std::vector<std::vector<Entry>> parts(chunks.size());
+    {
+        ThreadPool pool(std::min(threadCount, chunks.size()));
+        std::vector<std::future<void>> pending;
+        for (std::size_t i = 0; i < chunks.size(); ++i) {
+            pending.push_back(pool.submit([&, i]() {
+                parseChunk(chunks[i].first, chunks[i].second, parseLine, readLine, parts[i]);
+            }));
+        }
+        for (auto& f : pending) f.get();
+    }
+
+    std::size_t total = 0;
+    for (const auto& part : parts) total += part.size();
+    history.reserve(total);
+    for (auto& part : parts) {
+        std::move(part.begin(), part.end(), std::back_inserter(history));
+        std::vector<Entry>().swap(part);
+    }
+    return history;
+}
+
+bool tokenEquals(const char* b, const char* e, const std::string& value) {
+    return static_cast<std::size_t>(e - b) == value.size() && std::equal(b, e, value.begin());
+}
+
+struct LineMatch {
+    time_t timestamp;
+    const char* begin;
+    const char* end;
+};
+
+// Both logs start with <timestamp> <action> <roomName> <user>, so the filter is
+// evaluated on those raw tokens before anything is materialized.
+bool lineMatches(const char* p, const char* end, const HistoryFilter& filter, time_t& timestamp) {
+    const char* b;
+    const char* e;
+    long long number;
+    if (!nextToken(p, end, b, e) || !parseInteger(b, e, number)) return false;
+    timestamp = static_cast<time_t>(number);
+    if (filter.fromTime != 0 && timestamp < filter.fromTime) return false;
+    if (filter.toTime != 0 && timestamp > filter.toTime) return false;
+    if (!nextToken(p, end, b, e)) return false;
+    if (!filter.action.empty() && !tokenEquals(b, e, filter.action)) return false;
+    if (!nextToken(p, end, b, e)) return false;
+    if (!filter.roomName.empty() && !tokenEquals(b, e, filter.roomName)) return false;
+    if (!nextToken(p, end, b, e)) return false;
+    if (!filter.username.empty() && !tokenEquals(b, e, filter.username)) return false;
+    return true;
+}
+
+void collectMatches(const char* begin, const char* end, const HistoryFilter& filter, std::vector<LineMatch>& out) {
+    const char* lineBegin = begin;
+    while (lineBegin < end) {
+        const char* lineEnd = std::find(lineBegin, end, '\n');
+        time_t timestamp;
+        if (lineMatches(lineBegin, lineEnd, filter, timestamp)) {
+            out.push_back({timestamp, lineBegin, lineEnd});
+        }
+        lineBegin = lineEnd + 1;
+    }
+}
+
+// Filters on the raw lines, orders the (small) match records and only parses the
+// entries that fall inside the requested page.
+template <typename Entry, typename Parser>
+HistoryPage<Entry> queryLog(const std::string& path, const HistoryQuery& query, Parser parseLine) {
+    HistoryPage<Entry> page;
+    page.offset = query.offset;
+    std::string buffer;
+    if (!readWholeFile(path, buffer) || buffer.empty()) {
+        return page;
+    }
+
+    std::vector<LineMatch> matches;
+    if (buffer.size() >= PARALLEL_HISTORY_LOAD_THRESHOLD) {
+        std::size_t threadCount = ThreadPool::defaultThreadCount();
+        std::vector<std::pair<const char*, const char*>> chunks = splitIntoChunks(buffer, threadCount);
+        std::vector<std::vector<LineMatch>> parts(chunks.size());
+        {
+            ThreadPool pool(std::min(threadCount, chunks.size()));
+            std::vector<std::future<void>> pending;
+            for (std::size_t i = 0; i < chunks.size(); ++i) {
+                pending.push_back(pool.submit([&, i]() {
+                    collectMatches(chunks[i].first, chunks[i].second, query.filter, parts[i]);
+                }));
+            }
+            for (auto& f : pending) f.get();
+        }
+        for (const auto& part : parts) matches.insert(matches.end(), part.begin(), part.end());
+    } else {
+        collectMatches(buffer.data(), buffer.data() + buffer.size(), query.filter, matches);
+    }
+
+    auto byTimestamp = [](const LineMatch& a, const LineMatch& b) { return a.timestamp < b.timestamp; };
+    if (!std::is_sorted(matches.begin(), matches.end(), byTimestamp)) {
+        std::stable_sort(matches.begin(), matches.end(), byTimestamp);
+    }
+
+    page.totalMatches = matches.size();
+    if (query.offset >= matches.size()) {
+        return page;
+    }
+    std::size_t count = matches.size() - query.offset;
+    if (query.limit != 0 && query.limit < count) count = query.limit;
+    page.entries.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        std::size_t index = (query.order == HistorySortOrder::NEWEST_FIRST)
+            ? matches.size() - 1 - (query.offset + i)
+            : query.offset + i;
+        Entry entry;
+        if (parseLine(matches[index].begin, matches[index].end, entry)) {
+            page.entries.push_back(std::move(entry));
+        }
+    }
+    return page;
+}
+
+} // namespace
 
 // RoomHistoryManager implementation
-void RoomHistoryManager::logCreate(const std::string& roomName, const std::string& adminName, int capacity, bool isAvailable) {
-    std::ofstream historyFile(ROOM_HISTORY_FILE, std::ios::app);
-    if (historyFile.is_open()) {
-        historyFile << time(0) << " CREATE " << roomName << " " << adminName << " " << capacity << " " << (isAvailable ? "Yes" : "No") << std::endl;
+void RoomHistoryManager::beginBatch() {
+    std::lock_guard<std::mutex> lock(pendingMutex);
+    batchDepth++;
+}
+
+void RoomHistoryManager::endBatch() {
+    std::lock_guard<std::mutex> lock(pendingMutex);
+    if (batchDepth > 0 && --batchDepth == 0 && !pendingLines.empty()) {
+        Durability::append(ROOM_HISTORY_FILE, pendingLines);
+        pendingLines.clear();
     }
 }
 
-void RoomHistoryManager::logModify(const std::string& roomName, const std::string& adminName, int capacity, bool isAvailable) {
-    std::ofstream historyFile(ROOM_HISTORY_FILE, std::ios::app);
-    if (historyFile.is_open()) {
-        historyFile << time(0) << " MODIFY " << roomName << " " << adminName << " " << capacity << " " << (isAvailable ? "Yes" : "No") << std::endl;
+void RoomHistoryManager::write(const std::string& line) {
+    std::lock_guard<std::mutex> lock(pendingMutex);
+    if (batchDepth > 0) {
+        pendingLines += line;
+    } else {
+        Durability::append(ROOM_HISTORY_FILE, line);
     }
 }
 
+void RoomHistoryManager::logCreate(const std::string& roomName, const std::string& adminName, int capacity, bool isAvailable) {
+    std::ostringstream line;
+    line << time(0) << " CREATE " << roomName << " " << adminName << " " << capacity << " " << (isAvailable ? "Yes" : "No") << "\n";
+    write(line.str());
+}
+
+void RoomHistoryManager::logModify(const std::string& roomName, const std::string& adminName, int capacity, bool isAvailable) {
+    std::ostringstream line;
+    line << time(0) << " MODIFY " << roomName << " " << adminName << " " << capacity << " " << (isAvailable ? "Yes" : "No") << "\n";
+    write(line.str());
+}
+
 void RoomHistoryManager::logDelete(const std::string& roomName, const std::string& adminName) {
-    std::ofstream historyFile(ROOM_HISTORY_FILE, std::ios::app);
-    if (historyFile.is_open()) {
-        historyFile << time(0) << " DELETE " << roomName << " " << adminName << " -1 No" << std::endl;
-    }
+    std::ostringstream line;
+    line << time(0) << " DELETE " << roomName << " " << adminName << " -1 No\n";
+    write(line.str());
 }
 
 std::vector<RoomHistoryEntry> RoomHistoryManager::getAllHistory() {
+    if (fileSize(ROOM_HISTORY_FILE) >= PARALLEL_HISTORY_LOAD_THRESHOLD) {
+        return getAllHistoryParallel();
+    }
     std::vector<RoomHistoryEntry> history;
     std::ifstream historyFile(ROOM_HISTORY_FILE);
     std::string line;
     while (std::getline(historyFile, line)) {
-        std::stringstream ss(line);
-        RoomHistoryEntry entry;
-        std::string capacity_str, isAvailable_str;
-
-        ss >> entry.timestamp >> entry.action >> entry.roomName >> entry.adminName >> capacity_str >> isAvailable_str;
-        
-        try {
-            entry.capacity = std::stoi(capacity_str);
-        } catch (...) {
-            entry.capacity = -1; // For DELETE actions
-        }
-        entry.isAvailable = (isAvailable_str == "Yes");
-        history.push_back(entry);
+        history.push_back(readRoomHistoryLine(line));
     }
     return history;
 }
 
+std::vector<RoomHistoryEntry> RoomHistoryManager::getAllHistoryParallel(std::size_t threadCount) {
+    return loadLogParallel<RoomHistoryEntry>(ROOM_HISTORY_FILE, threadCount, parseRoomHistoryLine, readRoomHistoryLine);
+}
+
 std::vector<RoomHistoryEntry> RoomHistoryManager::getHistoryForRoom(const std::string& roomName) {
-    std::vector<RoomHistoryEntry> allHistory = getAllHistory();
-    std::vector<RoomHistoryEntry> roomHistory;
-    for (const auto& entry : allHistory) {
-        if (entry.roomName == roomName) {
-            roomHistory.push_back(entry);
-        }
-    }
-    return roomHistory;
+    HistoryQuery query;
+    query.filter.roomName = roomName;
+    return queryHistory(query).entries;
+}
+
+HistoryPage<RoomHistoryEntry> RoomHistoryManager::queryHistory(const HistoryQuery& query) {
+    return queryLog<RoomHistoryEntry>(ROOM_HISTORY_FILE, query, parseRoomHistoryLine);
 }
 
 // BookingHistoryManager implementation
-void BookingHistoryManager::logBooking(const std::string& roomName, const std::string& username) {
-    std::ofstream historyFile(BOOKING_HISTORY_FILE, std::ios::app);
-    if (historyFile.is_open()) {
-        historyFile << time(0) << " BOOK " << roomName << " " << username << std::endl;
+void BookingHistoryManager::beginBatch() {
+    std::lock_guard<std::mutex> lock(pendingMutex);
+    batchDepth++;
+}
+
+void BookingHistoryManager::endBatch() {
+    std::lock_guard<std::mutex> lock(pendingMutex);
+    if (batchDepth > 0 && --batchDepth == 0 && !pendingLines.empty()) {
+        Durability::append(BOOKING_HISTORY_FILE, pendingLines);
+        pendingLines.clear();
     }
 }
 
-void BookingHistoryManager::logRelease(const std::string& roomName, const std::string& username) {
-    std::ofstream historyFile(BOOKING_HISTORY_FILE, std::ios::app);
-    if (historyFile.is_open()) {
-        historyFile << time(0) << " RELEASE " << roomName << " " << username << std::endl;
+void BookingHistoryManager::write(const std::string& line) {
+    std::lock_guard<std::mutex> lock(pendingMutex);
+    if (batchDepth > 0) {
+        pendingLines += line;
+    } else {
+        Durability::append(BOOKING_HISTORY_FILE, line);
     }
 }
 
+void BookingHistoryManager::logBooking(const std::string& roomName, const std::string& username) {
+    std::ostringstream line;
+    line << time(0) << " BOOK " << roomName << " " << username << "\n";
+    write(line.str());
+}
+
+void BookingHistoryManager::logRelease(const std::string& roomName, const std::string& username) {
+    std::ostringstream line;
+    line << time(0) << " RELEASE " << roomName << " " << username << "\n";
+    write(line.str());
+}
+
 std::vector<BookingHistoryEntry> BookingHistoryManager::getAllHistory() {
+    if (fileSize(BOOKING_HISTORY_FILE) >= PARALLEL_HISTORY_LOAD_THRESHOLD) {
+        return getAllHistoryParallel();
+    }
     std::vector<BookingHistoryEntry> history;
     std::ifstream historyFile(BOOKING_HISTORY_FILE);
     std::string line;
     while (std::getline(historyFile, line)) {
-        std::stringstream ss(line);
-        BookingHistoryEntry entry;
-        ss >> entry.timestamp >> entry.action >> entry.roomName >> entry.username;
-        history.push_back(entry);
+        history.push_back(readBookingHistoryLine(line));
     }
     return history;
-}
\ No newline at end of file
+}
+
+std::vector<BookingHistoryEntry> BookingHistoryManager::getAllHistoryParallel(std::size_t threadCount) {
+    return loadLogParallel<BookingHistoryEntry>(BOOKING_HISTORY_FILE, threadCount, parseBookingHistoryLine, readBookingHistoryLine);
+}
+
+HistoryPage<BookingHistoryEntry> BookingHistoryManager::queryHistory(const HistoryQuery& query) {
+    return queryLog<BookingHistoryEntry>(BOOKING_HISTORY_FILE, query, parseBookingHistoryLine);
+}
@@ -4,9 +4,46 @@
 #include <string>
 #include <vector>
 #include <ctime>
+#include <cstddef>
+#include <mutex>
 
 const std::string ROOM_HISTORY_FILE = "output/room_history.log";
 const std::string BOOKING_HISTORY_FILE = "output/booking_history.log";
+// Logs at least this large are loaded with the parallel parser by getAllHistory().
+// Both paths return one entry per line in file order, so the result does not
+// depend on the size of the log.
+const std::size_t PARALLEL_HISTORY_LOAD_THRESHOLD = 4 * 1024 * 1024;
+
+// Empty strings and zero times mean "no constraint". For the room history the
+// username field matches the admin who made the change.
+struct HistoryFilter {
+    std::string username;
+    std::string roomName;
+    std::string action;
+    time_t fromTime = 0; // Inclusive
+    time_t toTime = 0;   // Inclusive
+};
+
+enum class HistorySortOrder {
+    OLDEST_FIRST,
+    NEWEST_FIRST
+};
+
+struct HistoryQuery {
+    HistoryFilter filter;
+    HistorySortOrder order = HistorySortOrder::OLDEST_FIRST;
+    std::size_t offset = 0;
+    std::size_t limit = 0; // 0 = all remaining matches
+};
+
+template <typename Entry>
+struct HistoryPage {
+    std::vector<Entry> entries;
+    std::size_t totalMatches = 0;
+    std::size_t offset = 0;
+
+    bool hasMore() const { return offset + entries.size() < totalMatches; }
+};
 
 struct RoomHistoryEntry {
     time_t timestamp;
@@ -19,11 +56,25 @@ struct RoomHistoryEntry {
 
 class RoomHistoryManager {
 public:
+    // Between beginBatch() and endBatch() log lines are buffered and appended with a single write
+    void beginBatch();
+    void endBatch();
     void logCreate(const std::string& roomName, const std::string& adminName, int capacity, bool isAvailable);
     void logModify(const std::string& roomName, const std::string& adminName, int capacity, bool isAvailable);
     void logDelete(const std::string& roomName, const std::string& adminName);
     std::vector<RoomHistoryEntry> getHistoryForRoom(const std::string& roomName);
     std::vector<RoomHistoryEntry> getAllHistory();
+    // Splits the log into newline-aligned chunks parsed on a thread pool; 0 threads = hardware concurrency
+    std::vector<RoomHistoryEntry> getAllHistoryParallel(std::size_t threadCount = 0);
+    // Filters while scanning and only materializes the requested page
+    HistoryPage<RoomHistoryEntry> queryHistory(const HistoryQuery& query);
+
+private:
+    int batchDepth = 0;
+    std::string pendingLines;
+    std::mutex pendingMutex; // Batched lines may come from parallel offline replay
+
+    void write(const std::string& line);
 };
 
 struct BookingHistoryEntry {
@@ -35,9 +86,20 @@ struct BookingHistoryEntry {
 
 class BookingHistoryManager {
 public:
+    void beginBatch();
+    void endBatch();
     void logBooking(const std::string& roomName, const std::string& username);
     void logRelease(const std::string& roomName, const std::string& username);
     std::vector<BookingHistoryEntry> getAllHistory();
+    std::vector<BookingHistoryEntry> getAllHistoryParallel(std::size_t threadCount = 0);
+    HistoryPage<BookingHistoryEntry> queryHistory(const HistoryQuery& query);
+
+private:
+    int batchDepth = 0;
+    std::string pendingLines;
+    std::mutex pendingMutex; // Batched lines may come from parallel offline replay
+
+    void write(const std::string& line);
 };
 
 #endif // HISTORY_HPP
\ No newline at end of file
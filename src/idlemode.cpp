@@ -0,0 +1,182 @@
+#include "idlemode.hpp"
+#include "raylib.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Part of the GLFW build inside raylib; wakes a blocked glfwWaitEvents() and may be called from any thread
+extern "C" void glfwPostEmptyEvent(void);
+
+namespace {
+
+const double INPUT_GRACE_SECONDS = 0.5;
+const int SAMPLE_INTERVAL_MS = 250;
+
+struct IdleState {
+    std::mutex mutex;
+    std::condition_variable wake;
+    IdleMode::Mode mode = IdleMode::Mode::CONTINUOUS; // Until configured
+    std::vector<IdleMode::Probe> probes;
+    std::vector<std::uint64_t> lastValues;
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+    std::thread sampler;
+    bool stopSampler = false;
+
+    // GUI thread only
+    bool waiting = false; // EnableEventWaiting() is in effect
+    bool awake = false;
+    double activeUntil = 0;
+    std::uint64_t wakeCount = 0;
+
+    ~IdleState() {
+        stopSamplerThread();
+    }
+
+    void startSamplerThread();
+    void stopSamplerThread();
+    void sample();
+};
+
+IdleState& state() {
+    static IdleState instance;
+    return instance;
+}
+
+void IdleState::startSamplerThread() {
+    if (sampler.joinable()) return;
+    stopSampler = false;
+    sampler = std::thread([this] { sample(); });
+}
+
+void IdleState::stopSamplerThread() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopSampler = true;
+    }
+    wake.notify_all();
+    if (sampler.joinable()) {
+        sampler.join();
+    }
+}
+
+void IdleState::sample() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!stopSampler) {
+        auto next = std::chrono::steady_clock::now() + std::chrono::milliseconds(SAMPLE_INTERVAL_MS);
+        if (deadline < next) next = deadline;
+        wake.wait_until(lock, next);
+        if (stopSampler) break;
+
+        bool changed = false;
+        if (std::chrono::steady_clock::now() >= deadline) {
+            deadline = std::chrono::steady_clock::time_point::max();
+            changed = true;
+        }
+        for (std::size_t i = 0; i < probes.size(); ++i) {
+            std::uint64_t value = probes[i]();
+            if (value != lastValues[i]) {
+                lastValues[i] = value;
+                changed = true;
+            }
+        }
+        if (changed) {
+            glfwPostEmptyEvent();
+        }
+    }
+}
+
+} // namespace
+
+void IdleMode::configure(Mode mode) {
+    IdleState& s = state();
+    {
+        std::lock_guard<std::mutex> lock(s.mutex);
+        s.mode = mode;
+    }
+    if (mode == Mode::IDLE) {
+        s.startSamplerThread();
+    } else {
+        s.stopSamplerThread();
+        if (s.waiting) {
+            DisableEventWaiting();
+            s.waiting = false;
+        }
+    }
+}
+
+void IdleMode::configureFromEnvironment() {
+    const char* value = std::getenv("IFM_RENDER");
+    std::string setting = value ? value : "idle";
+    configure(setting == "continuous" ? Mode::CONTINUOUS : Mode::IDLE);
+}
+
+IdleMode::Mode IdleMode::getMode() {
+    std::lock_guard<std::mutex> lock(state().mutex);
+    return state().mode;
+}
+
+std::string IdleMode::describe() {
+    return getMode() == Mode::IDLE ? "idle (wait for events)" : "continuous";
+}
+
+void IdleMode::watch(Probe probe) {
+    IdleState& s = state();
+    std::uint64_t initial = probe();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    s.probes.push_back(std::move(probe));
+    s.lastValues.push_back(initial);
+}
+
+void IdleMode::wakeAfter(double seconds) {
+    IdleState& s = state();
+    auto at = std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(seconds > 0 ? seconds : 0));
+    {
+        std::lock_guard<std::mutex> lock(s.mutex);
+        if (at >= s.deadline) return;
+        s.deadline = at;
+    }
+    s.wake.notify_all(); // The sampler may be sleeping past the new deadline
+}
+
+void IdleMode::keepAwake() {
+    state().awake = true;
+}
+
+void IdleMode::endFrame() {
+    IdleState& s = state();
+    if (getMode() != Mode::IDLE) return;
+
+    double now = GetTime();
+    if (s.waiting) {
+        // The loop was waiting, so this frame was started by an event
+        s.wakeCount++;
+        s.activeUntil = now + INPUT_GRACE_SECONDS;
+    }
+    Vector2 mouseDelta = GetMouseDelta();
+    if (mouseDelta.x != 0 || mouseDelta.y != 0 || GetMouseWheelMove() != 0 ||
+        IsMouseButtonDown(MOUSE_BUTTON_LEFT) || IsMouseButtonDown(MOUSE_BUTTON_RIGHT) || IsMouseButtonDown(MOUSE_BUTTON_MIDDLE)) {
+        s.activeUntil = now + INPUT_GRACE_SECONDS;
+    }
+
+    bool wait = !s.awake && now >= s.activeUntil;
+    s.awake = false;
+    if (wait != s.waiting) {
+        if (wait) {
+            EnableEventWaiting();
+        } else {
+            DisableEventWaiting();
+        }
+        s.waiting = wait;
+    }
+}
+
+void IdleMode::shutdown() {
+    state().stopSamplerThread();
+}
+
+std::uint64_t IdleMode::getWakeCount() {
+    return state().wakeCount;
+}
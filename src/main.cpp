@@ -4,6 +4,7 @@
 #include "room.hpp"
 #include "meetingroom.hpp"
 #include "offlinemechanism.hpp"
+#include "durability.hpp"
 #include <iostream>
 #include <string>
 
@@ -11,6 +12,8 @@ void handleAdminMenu(const std::string& username, Authentication& auth, RoomMana
 void handleUserMenu(const std::string& username, RoomBookingSystem& rbs, OfflineManager& om);
 
 int main() {
+    Durability::configureFromEnvironment();
+    Durability::recover(); // Finishes a commit cut short by a crash
     Authentication auth;
     RoomManager rm;
     RoomBookingSystem rbs(rm);
@@ -145,7 +148,26 @@ void handleAdminMenu(const std::string& username, Authentication& auth, RoomMana
                 }
                 break;
             }
-            case 6:
+            case 6: {
+                if (om.isOffline()) {
+                    // Imports bypass the offline queue
+                    UI::displayMessage("Import is unavailable while offline.");
+                    break;
+                }
+                std::string importPath;
+                std::cout << "Enter the path of the CSV/TSV file (username,password[,role]): ";
+                std::cin >> importPath;
+                Authentication::ImportReport report;
+                auth.importUsers(importPath, report);
+                for (const auto& error : report.errors) {
+                    std::cout << "Line " << error.line << ": " << error.message << std::endl;
+                }
+                std::cout << "Imported " << report.imported << " of " << report.rowsRead << " rows in "
+                          << report.totalMs << " ms (" << report.rowsPerSecond() << " rows/s; hashing "
+                          << report.hashMs << " ms, persisting " << report.persistMs << " ms)" << std::endl;
+                break;
+            }
+            case 7:
                 return;
             default:
                 UI::displayInvalidChoice();
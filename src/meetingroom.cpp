@@ -19,6 +19,14 @@ RoomBookingSystem::RoomBookingSystem(RoomManager& rm) : rm(rm) {
     bookingHistoryManager = new BookingHistoryManager();
 }
 
+void RoomBookingSystem::beginBatch() {
+    bookingHistoryManager->beginBatch();
+}
+
+void RoomBookingSystem::endBatch() {
+    bookingHistoryManager->endBatch();
+}
+
 void RoomBookingSystem::suggestRoom(int participants) {
 
     std::vector<Room> suitableRooms;
@@ -125,6 +133,10 @@ void RoomBookingSystem::bookRoom(const std::string& username) {
 
 
 
+                rm.markModified(*room);
+
+
+
                 rm.saveRooms();
 
 
@@ -195,6 +207,7 @@ Room* RoomBookingSystem::bookRoom(const std::string& username, int participants,
         roomToBook->setAvailable(false);
         roomToBook->setBookedBy(username);
         bookingHistoryManager->logBooking(roomToBook->getName(), username);
+        rm.markModified(*roomToBook);
         rm.saveRooms();
         return roomToBook;
     }
@@ -243,6 +256,7 @@ ReleaseRoomStatus RoomBookingSystem::releaseRoom(const std::string& username, co
             room->setAvailable(true);
             room->setBookedBy(""); // Clear bookedBy
             bookingHistoryManager->logRelease(roomName, username);
+            rm.markModified(*room);
             rm.saveRooms();
             if (!isGui) {
                 UI::displayMessage("Room released");
@@ -3,12 +3,359 @@
 #include "room.hpp"
 #include "auth.hpp"
 #include "meetingroom.hpp"
+#include "durability.hpp"
+#include "compression.hpp"
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <unordered_map>
+
+namespace {
+
+// FNV-1a; only has to catch torn or partially flushed records, not tampering
+std::uint32_t checksum(const char* data, std::size_t length) {
+    std::uint32_t hash = 2166136261u;
+    for (std::size_t i = 0; i < length; ++i) {
+        hash ^= static_cast<std::uint8_t>(data[i]);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+void putU32(std::string& out, std::uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        out += static_cast<char>((value >> (8 * i)) & 0xff);
+    }
+}
+
+void putU64(std::string& out, std::uint64_t value) {
+    putU32(out, static_cast<std::uint32_t>(value));
+    putU32(out, static_cast<std::uint32_t>(value >> 32));
+}
+
+void putString(std::string& out, const std::string& value) {
+    putU32(out, static_cast<std::uint32_t>(value.size()));
+    out += value;
+}
+
+bool getU32(const std::string& in, std::size_t& pos, std::uint32_t& value) {
+    if (in.size() - pos < 4) return false;
+    value = 0;
+    for (int i = 0; i < 4; ++i) {
+        value |= static_cast<std::uint32_t>(static_cast<std::uint8_t>(in[pos + i])) << (8 * i);
+    }
+    pos += 4;
+    return true;
+}
+
+bool getU64(const std::string& in, std::size_t& pos, std::uint64_t& value) {
+    std::uint32_t low, high;
+    if (!getU32(in, pos, low) || !getU32(in, pos, high)) return false;
+    value = (static_cast<std::uint64_t>(high) << 32) | low;
+    return true;
+}
+
+bool getString(const std::string& in, std::size_t& pos, std::string& value) {
+    std::uint32_t length;
+    if (!getU32(in, pos, length) || in.size() - pos < length) return false;
+    value.assign(in, pos, length);
+    pos += length;
+    return true;
+}
+
+std::string encodeRecord(const OfflineOp& op) {
+    std::string payload;
+    payload += static_cast<char>(op.type);
+    putString(payload, op.actor);
+    putString(payload, op.target);
+    putString(payload, op.secret);
+    putU32(payload, static_cast<std::uint32_t>(op.number));
+    payload += static_cast<char>(op.flag ? 1 : 0);
+    payload += static_cast<char>(op.role == Authentication::Role::ADMIN ? 1 : 0);
+    putU64(payload, op.seq);
+    putU64(payload, op.baseVersion);
+    putU32(payload, static_cast<std::uint32_t>(op.baseNumber));
+    payload += static_cast<char>((op.baseFlag ? 1 : 0) | (op.baseRole == Authentication::Role::ADMIN ? 2 : 0));
+
+    std::string record;
+    putU32(record, static_cast<std::uint32_t>(payload.size()));
+    record += payload;
+    putU32(record, checksum(payload.data(), payload.size()));
+    return record;
+}
+
+bool decodePayload(const std::string& payload, OfflineOp& op) {
+    std::size_t pos = 0;
+    if (payload.empty() || static_cast<std::uint8_t>(payload[0]) > static_cast<std::uint8_t>(OfflineOp::Type::RELEASE_ROOM)) {
+        return false;
+    }
+    op.type = static_cast<OfflineOp::Type>(payload[pos++]);
+    std::uint32_t number;
+    if (!getString(payload, pos, op.actor) || !getString(payload, pos, op.target) || !getString(payload, pos, op.secret) ||
+        !getU32(payload, pos, number) || payload.size() - pos < 2) {
+        return false;
+    }
+    op.number = static_cast<int>(number);
+    op.flag = payload[pos++] != 0;
+    op.role = payload[pos++] != 0 ? Authentication::Role::ADMIN : Authentication::Role::USER;
+    // Older records end after the role byte, or after the sequence number
+    op.seq = 0;
+    op.baseVersion = 0;
+    op.baseNumber = 0;
+    op.baseFlag = false;
+    op.baseRole = Authentication::Role::USER;
+    std::uint32_t baseNumber;
+    switch (payload.size() - pos) {
+        case 0:
+            return true;
+        case 8:
+            return getU64(payload, pos, op.seq);
+        case 21:
+            getU64(payload, pos, op.seq);
+            getU64(payload, pos, op.baseVersion);
+            getU32(payload, pos, baseNumber);
+            op.baseNumber = static_cast<int>(baseNumber);
+            op.baseFlag = (payload[pos] & 1) != 0;
+            op.baseRole = (payload[pos] & 2) != 0 ? Authentication::Role::ADMIN : Authentication::Role::USER;
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Parses one line of the old text queue; false for blank or unknown lines
+bool parseLegacyLine(const std::string& line, OfflineOp& op) {
+    std::stringstream ss(line);
+    std::string action;
+    ss >> action;
+    op = OfflineOp{};
+    if (action == "UPLOAD_ROOM" || action == "MODIFY_ROOM") {
+        std::string isAvailable_str;
+        ss >> op.actor >> op.target >> op.number >> isAvailable_str;
+        op.type = action == "UPLOAD_ROOM" ? OfflineOp::Type::UPLOAD_ROOM : OfflineOp::Type::MODIFY_ROOM;
+        op.flag = isAvailable_str == "Yes";
+    } else if (action == "REGISTER_NEW_ADMIN") {
+        op.type = OfflineOp::Type::REGISTER_NEW_ADMIN;
+        ss >> op.actor >> op.target >> op.secret;
+    } else if (action == "BOOK_ROOM") {
+        op.type = OfflineOp::Type::BOOK_ROOM;
+        ss >> op.actor >> op.number >> op.target;
+    } else if (action == "DELETE_USER") {
+        op.type = OfflineOp::Type::DELETE_USER;
+        ss >> op.target;
+    } else if (action == "EDIT_USER") {
+        std::string newRoleStr;
+        op.type = OfflineOp::Type::EDIT_USER;
+        ss >> op.target >> op.secret >> newRoleStr;
+        op.role = (newRoleStr == "ADMIN") ? Authentication::Role::ADMIN : Authentication::Role::USER;
+    } else if (action == "RELEASE_ROOM") {
+        op.type = OfflineOp::Type::RELEASE_ROOM;
+        ss >> op.actor >> op.target;
+    } else if (action == "DELETE_ROOM") {
+        op.type = OfflineOp::Type::DELETE_ROOM;
+        ss >> op.target >> op.actor;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+std::string readWholeFile(const std::string& path, std::uint64_t fromOffset = 0) {
+    std::ifstream file(path, std::ios::binary);
+    std::ostringstream contents;
+    if (file.is_open() && file.seekg(static_cast<std::streamoff>(fromOffset))) {
+        contents << file.rdbuf();
+    }
+    return contents.str();
+}
+
+// Parses one record at pos; false (pos unchanged) at the end or on a torn or damaged record
+bool readRecord(const std::string& log, std::size_t& pos, OfflineOp& op) {
+    std::size_t next = pos;
+    std::uint32_t length;
+    std::uint32_t storedChecksum = 0;
+    if (!getU32(log, next, length) || log.size() - next < static_cast<std::size_t>(length) + 4) {
+        return false;
+    }
+    std::string payload = log.substr(next, length);
+    next += length;
+    getU32(log, next, storedChecksum);
+    if (storedChecksum != checksum(payload.data(), payload.size()) || !decodePayload(payload, op)) {
+        return false;
+    }
+    pos = next;
+    return true;
+}
+
+// The persisted fields of one room as seen by the compaction simulation
+struct RoomShadow {
+    bool exists = false;
+    int capacity = 0;
+    bool available = false;
+    std::string bookedBy;
+    std::string lastModifiedBy;
+
+    bool operator==(const RoomShadow& other) const {
+        return exists == other.exists && capacity == other.capacity && available == other.available &&
+               bookedBy == other.bookedBy && lastModifiedBy == other.lastModifiedBy;
+    }
+};
+
+// Mirrors RoomManager / RoomBookingSystem for a single, named room
+RoomShadow applyToRoom(const OfflineOp& op, RoomShadow room) {
+    switch (op.type) {
+        case OfflineOp::Type::UPLOAD_ROOM:
+            if (!room.exists) {
+                room = RoomShadow{true, op.number, op.flag, "", op.actor};
+            }
+            break;
+        case OfflineOp::Type::MODIFY_ROOM:
+            if (room.exists) {
+                room.capacity = op.number;
+                room.available = op.flag;
+                room.lastModifiedBy = op.actor;
+            }
+            break;
+        case OfflineOp::Type::DELETE_ROOM:
+            room = RoomShadow{};
+            break;
+        case OfflineOp::Type::BOOK_ROOM:
+            if (room.exists && room.available && room.capacity >= op.number) {
+                room.available = false;
+                room.bookedBy = op.actor;
+            }
+            break;
+        case OfflineOp::Type::RELEASE_ROOM:
+            if (room.exists && !room.available && room.bookedBy == op.actor) {
+                room.available = true;
+                room.bookedBy = "";
+            }
+            break;
+        default:
+            break;
+    }
+    return room;
+}
+
+bool isRoomOperation(OfflineOp::Type type) {
+    return type == OfflineOp::Type::UPLOAD_ROOM || type == OfflineOp::Type::MODIFY_ROOM || type == OfflineOp::Type::DELETE_ROOM ||
+           type == OfflineOp::Type::BOOK_ROOM || type == OfflineOp::Type::RELEASE_ROOM;
+}
+
+// Picks the best-fitting free room, so it depends on every room
+bool isAnyRoomBooking(const OfflineOp& op) {
+    return op.type == OfflineOp::Type::BOOK_ROOM && op.target.empty();
+}
+
+std::string keyFor(const OfflineOp& op) {
+    return (isRoomOperation(op.type) ? "room:" : "user:") + op.target;
+}
+
+void copyBase(const OfflineOp& from, OfflineOp& to) {
+    to.baseVersion = from.baseVersion;
+    to.baseNumber = from.baseNumber;
+    to.baseFlag = from.baseFlag;
+    to.baseRole = from.baseRole;
+}
+
+// Spill segment header: magic, op count, first and last seq, uncompressed size, checksum of the compressed block
+const std::uint32_t SEGMENT_MAGIC = 0x53514649; // "IFQS"
+const std::size_t SEGMENT_HEADER_SIZE = 32;
+
+// Rough heap cost of a queued op: the struct, its strings and its display line
+std::size_t footprint(const OfflineOp& op) {
+    return sizeof(OfflineOp) + 2 * (op.actor.size() + op.target.size() + op.secret.size()) + 32;
+}
+
+// "<n>", "<n>K", "<n>M" or "<n>G"; the fallback when unset or unreadable
+std::size_t sizeFromEnvironment(const char* name, std::size_t fallback) {
+    const char* value = std::getenv(name);
+    if (!value || !*value) return fallback;
+    char* end = nullptr;
+    unsigned long long size = std::strtoull(value, &end, 10);
+    if (end == value) return fallback;
+    switch (*end) {
+        case 'G': case 'g': size <<= 30; break;
+        case 'M': case 'm': size <<= 20; break;
+        case 'K': case 'k': size <<= 10; break;
+        default: break;
+    }
+    return static_cast<std::size_t>(size);
+}
+
+bool parseSegmentHeader(const std::string& data, std::uint32_t& count, std::uint64_t& firstSeq, std::uint64_t& lastSeq,
+                        std::uint32_t& rawSize, std::uint32_t& storedChecksum) {
+    std::size_t pos = 0;
+    std::uint32_t magic = 0;
+    return getU32(data, pos, magic) && magic == SEGMENT_MAGIC && getU32(data, pos, count) && getU64(data, pos, firstSeq) &&
+           getU64(data, pos, lastSeq) && getU32(data, pos, rawSize) && getU32(data, pos, storedChecksum);
+}
+
+OfflineManager::ConflictPolicy policyFromEnvironment() {
+    const char* value = std::getenv("IFM_CONFLICT_POLICY");
+    std::string policy = value ? value : "";
+    if (policy == "reject") return OfflineManager::ConflictPolicy::REJECT;
+    if (policy == "merge") return OfflineManager::ConflictPolicy::MERGE;
+    return OfflineManager::ConflictPolicy::LAST_WRITER_WINS;
+}
+
+} // namespace
+
+std::string OfflineOp::describe() const {
+    std::ostringstream line;
+    switch (type) {
+        case Type::UPLOAD_ROOM:
+            line << "UPLOAD_ROOM " << actor << " " << target << " " << number << " " << (flag ? "Yes" : "No");
+            break;
+        case Type::MODIFY_ROOM:
+            line << "MODIFY_ROOM " << actor << " " << target << " " << number << " " << (flag ? "Yes" : "No");
+            break;
+        case Type::REGISTER_NEW_ADMIN:
+            line << "REGISTER_NEW_ADMIN " << actor << " " << target << " " << secret;
+            break;
+        case Type::BOOK_ROOM:
+            line << "BOOK_ROOM " << actor << " " << number << " " << target;
+            break;
+        case Type::DELETE_USER:
+            line << "DELETE_USER " << target;
+            break;
+        case Type::EDIT_USER:
+            line << "EDIT_USER " << target << " " << secret << " " << (role == Authentication::Role::ADMIN ? "ADMIN" : "USER");
+            break;
+        case Type::DELETE_ROOM:
+            line << "DELETE_ROOM " << target << " " << actor;
+            break;
+        case Type::RELEASE_ROOM:
+            line << "RELEASE_ROOM " << actor << " " << target;
+            break;
+    }
+    return line.str();
+}
 
 OfflineManager::OfflineManager(Authentication& auth, RoomManager& rm, RoomBookingSystem& rbs)
-    : auth(auth), rm(rm), rbs(rbs), offline(false) {}
+    : auth(auth), rm(rm), rbs(rbs), offline(false), queueBytes(0), spilledOps(0), spilledBytes(0),
+      memoryBudget(sizeFromEnvironment("IFM_OFFLINE_MEMORY", std::size_t(4) << 20)),
+      spillLimit(sizeFromEnvironment("IFM_OFFLINE_SPILL_LIMIT", std::size_t(256) << 20)), appliedThrough(0), replaying(false),
+      nextSeq(1), queueVersion(1), displayVersion(0),
+      stateWaiters(0), syncRunning(false), cancelRequested(false), syncApplied(0), syncTotal(0),
+      conflictPolicy(policyFromEnvironment()), replayThreads(0), overlay(rm, auth) {
+    migrateLegacyQueue();
+    loadQueue();
+}
+
+OfflineManager::~OfflineManager() {
+    cancelSync();
+    if (syncThread.joinable()) {
+        syncThread.join();
+    }
+}
 
 void OfflineManager::goOffline() {
     offline = true;
@@ -25,152 +372,1020 @@ bool OfflineManager::isOffline() const {
     return offline;
 }
 
-void OfflineManager::queueUploadRoom(const std::string& adminName, const std::string& roomName, int capacity, bool isAvailable) {
-    std::ofstream offlineFile(OFFLINE_CHANGES_FILE, std::ios::app);
-    if (offlineFile.is_open()) {
-        offlineFile << "UPLOAD_ROOM " << adminName << " " << roomName << " " << capacity << " " << (isAvailable ? "Yes" : "No") << std::endl;
-        offlineFile.close();
-        UI::displayMessage("Offline action: Upload room '" + roomName + "' queued.");
-    } else {
-        UI::displayMessage("Error: Unable to save offline changes.");
+void OfflineManager::goOnlineInBackground() {
+    offline = false;
+    UI::displayMessage("\nYou are now back online.");
+    startBackgroundSync();
+}
+
+bool OfflineManager::startBackgroundSync() {
+    if (syncRunning) {
+        return false;
+    }
+    if (syncThread.joinable()) {
+        syncThread.join(); // Previous worker has already finished
     }
+    cancelRequested = false;
+    syncRunning = true;
+    syncThread = std::thread([this]() {
+        synchronizeChanges();
+        syncRunning = false;
+    });
+    return true;
 }
 
-void OfflineManager::queueModifyRoom(const std::string& adminName, const std::string& roomName, int capacity, bool isAvailable) {
-    std::ofstream offlineFile(OFFLINE_CHANGES_FILE, std::ios::app);
-    if (offlineFile.is_open()) {
-        offlineFile << "MODIFY_ROOM " << adminName << " " << roomName << " " << capacity << " " << (isAvailable ? "Yes" : "No") << std::endl;
-        offlineFile.close();
-        UI::displayMessage("Offline action: Modify room '" + roomName + "' queued.");
-    } else {
-        UI::displayMessage("Error: Unable to save offline changes.");
+void OfflineManager::cancelSync() {
+    cancelRequested = true;
+}
+
+OfflineManager::SyncProgress OfflineManager::getSyncProgress() const {
+    return SyncProgress{syncRunning, syncApplied, syncTotal};
+}
+
+std::unique_lock<std::mutex> OfflineManager::acquireState() {
+    stateWaiters++;
+    std::unique_lock<std::mutex> lock(stateMutex);
+    stateWaiters--;
+    return lock;
+}
+
+void OfflineManager::setConflictPolicy(ConflictPolicy policy) {
+    conflictPolicy = policy;
+}
+
+OfflineManager::ConflictPolicy OfflineManager::getConflictPolicy() const {
+    return conflictPolicy;
+}
+
+const std::vector<OfflineManager::SyncConflict>& OfflineManager::getLastConflicts() const {
+    return lastConflicts;
+}
+
+// Reads every intact record; anything after the first bad length or checksum
+// is a torn write from a crash and is cut off so later appends start clean.
+// A sync checkpoint marks the last op a previous sync persisted: every op up
+// to its sequence number is skipped, and when the log record at its offset
+// still carries that number, everything before it is not even read. Spilled
+// segments are only indexed here; their ops are read back when replayed.
+void OfflineManager::loadQueue() {
+    queue.clear();
+    std::uint64_t checkpointSeq = 0;
+    std::uint64_t checkpointOffset = 0;
+    std::ifstream checkpointFile(SYNC_CHECKPOINT_FILE);
+    bool hasCheckpoint = static_cast<bool>(checkpointFile >> checkpointSeq >> checkpointOffset);
+    checkpointFile.close();
+    if (!hasCheckpoint) {
+        checkpointSeq = 0;
+    }
+    appliedThrough = checkpointSeq;
+    loadSegments(checkpointSeq);
+    // A crash between writing a segment and shortening the log leaves its ops in both
+    std::uint64_t skipThrough = std::max(checkpointSeq, segments.empty() ? 0 : segments.back().lastSeq);
+
+    std::uint64_t base = 0;
+    std::string log;
+    if (hasCheckpoint) {
+        log = readWholeFile(OFFLINE_QUEUE_LOG, checkpointOffset);
+        std::size_t pos = 0;
+        OfflineOp applied;
+        if (readRecord(log, pos, applied) && applied.seq == checkpointSeq) {
+            base = checkpointOffset + pos;
+            log.erase(0, pos);
+            UI::displayMessage("Resuming an interrupted synchronization.");
+        } else {
+            hasCheckpoint = false; // Left behind by a finished sync, or pointing into a spilled segment
+        }
+    }
+    if (!hasCheckpoint) {
+        log = readWholeFile(OFFLINE_QUEUE_LOG);
+    }
+
+    nextSeq = skipThrough + 1;
+    std::size_t pos = 0;
+    OfflineOp op;
+    while (readRecord(log, pos, op)) {
+        if (op.seq != 0 && op.seq <= skipThrough) continue;
+        queue.push_back(op);
+        nextSeq = std::max(nextSeq, op.seq + 1);
     }
+    // Records from before sequence numbers existed get theirs now
+    for (auto& queued : queue) {
+        if (queued.seq == 0) queued.seq = nextSeq++;
+    }
+    if (pos < log.size()) {
+        UI::displayMessage("Warning: Discarded a damaged tail of the offline queue (" + std::to_string(log.size() - pos) + " bytes).");
+        Durability::truncate(OFFLINE_QUEUE_LOG, static_cast<std::size_t>(base + pos));
+    }
+    recountQueueBytes();
+    if (queueBytes > memoryBudget) {
+        spillOldest();
+    }
+    rebuildOverlay();
+    queueVersion++;
 }
 
-void OfflineManager::queueRegisterNewAdmin(const std::string& adminName, const std::string& newAdminUsername, const std::string& newAdminPassword) {
-    std::ofstream offlineFile(OFFLINE_CHANGES_FILE, std::ios::app);
-    if (offlineFile.is_open()) {
-        offlineFile << "REGISTER_NEW_ADMIN " << adminName << " " << newAdminUsername << " " << newAdminPassword << std::endl;
-        offlineFile.close();
-        UI::displayMessage("Offline action: Register new admin '" + newAdminUsername + "' queued.");
-    } else {
-        UI::displayMessage("Error: Unable to save offline changes.");
+// Segments are named by first seq, zero-padded, so name order is queue order.
+// Ones a checkpoint covers entirely are left over from an interrupted sync.
+void OfflineManager::loadSegments(std::uint64_t checkpointSeq) {
+    segments.clear();
+    spilledOps = 0;
+    spilledBytes = 0;
+    std::error_code ec;
+    std::vector<std::filesystem::path> paths;
+    for (const auto& entry : std::filesystem::directory_iterator(OFFLINE_SPILL_DIR, ec)) {
+        if (entry.path().extension() == ".seg") {
+            paths.push_back(entry.path());
+        }
+    }
+    std::sort(paths.begin(), paths.end());
+    for (const auto& path : paths) {
+        std::ifstream file(path, std::ios::binary);
+        std::string header(SEGMENT_HEADER_SIZE, '\0');
+        file.read(&header[0], static_cast<std::streamsize>(header.size()));
+        std::uint32_t count = 0, rawSize = 0, storedChecksum = 0;
+        SpillSegment segment{path.string(), 0, 0, 0, 0};
+        bool valid = file.gcount() == static_cast<std::streamsize>(SEGMENT_HEADER_SIZE) &&
+                     parseSegmentHeader(header, count, segment.firstSeq, segment.lastSeq, rawSize, storedChecksum);
+        file.close();
+        if (!valid) {
+            UI::displayMessage("Warning: Set aside a damaged offline spill segment: " + segment.path);
+            std::filesystem::rename(path, path.string() + ".damaged", ec);
+            continue;
+        }
+        if (segment.lastSeq <= checkpointSeq) {
+            std::filesystem::remove(path, ec);
+            continue;
+        }
+        segment.count = count;
+        segment.bytes = static_cast<std::size_t>(std::filesystem::file_size(path, ec));
+        segments.push_back(segment);
+        spilledOps += segment.count;
+        spilledBytes += segment.bytes;
+        nextSeq = std::max(nextSeq, segment.lastSeq + 1);
     }
 }
 
-void OfflineManager::queueDeleteUser(const std::string& targetUsername) {
-    std::ofstream offlineFile(OFFLINE_CHANGES_FILE, std::ios::app);
-    if (offlineFile.is_open()) {
-        offlineFile << "DELETE_USER " << targetUsername << std::endl;
-        offlineFile.close();
-        UI::displayMessage("Offline action: Delete user/admin '" + targetUsername + "' queued.");
-    } else {
-        UI::displayMessage("Error: Unable to save offline changes.");
+// Moves the oldest in-memory ops into a compressed segment until what is left
+// fits in half the budget, then shortens the log to the ops still in memory.
+// The segment is on disk before the log drops them; a crash in between is
+// covered by loadQueue() skipping log records the last segment already has.
+void OfflineManager::spillOldest() {
+    if (spilledBytes >= spillLimit) {
+        return; // Nowhere left to put them; enqueue() refuses new ops once memory is full
     }
+    std::size_t keepBytes = queueBytes;
+    std::size_t count = 0;
+    while (count < queue.size() && keepBytes > memoryBudget / 2) {
+        keepBytes -= footprint(queue[count++]);
+    }
+    SpillSegment segment;
+    if (count == 0 || !writeSegment(queue, count, segment)) {
+        return;
+    }
+    segments.push_back(segment);
+    spilledOps += segment.count;
+    spilledBytes += segment.bytes;
+    queue.erase(queue.begin(), queue.begin() + static_cast<std::ptrdiff_t>(count));
+    queueBytes = keepBytes;
+    queueVersion++;
+    rewriteLog();
 }
 
-void OfflineManager::queueEditUser(const std::string& targetUsername, const std::string& newPassword, Authentication::Role newRole) {
-    std::ofstream offlineFile(OFFLINE_CHANGES_FILE, std::ios::app);
-    if (offlineFile.is_open()) {
-        offlineFile << "EDIT_USER " << targetUsername << " " << newPassword << " " << (newRole == Authentication::Role::ADMIN ? "ADMIN" : "USER") << std::endl;
-        offlineFile.close();
-        UI::displayMessage("Offline action: Edit user/admin '" + targetUsername + "' queued.");
-    } else {
-        UI::displayMessage("Error: Unable to save offline changes.");
+// Writes ops[0, count) as one segment
+bool OfflineManager::writeSegment(const std::vector<OfflineOp>& ops, std::size_t count, SpillSegment& segment) {
+    std::string records;
+    for (std::size_t i = 0; i < count; ++i) {
+        records += encodeRecord(ops[i]);
     }
+    std::string compressed = Compression::compress(records);
+    std::string data;
+    putU32(data, SEGMENT_MAGIC);
+    putU32(data, static_cast<std::uint32_t>(count));
+    putU64(data, ops[0].seq);
+    putU64(data, ops[count - 1].seq);
+    putU32(data, static_cast<std::uint32_t>(records.size()));
+    putU32(data, checksum(compressed.data(), compressed.size()));
+    data += compressed;
+
+    std::string name = std::to_string(ops[0].seq);
+    name.insert(0, 20 - std::min<std::size_t>(name.size(), 20), '0');
+    segment = SpillSegment{OFFLINE_SPILL_DIR + "/" + name + ".seg", ops[0].seq, ops[count - 1].seq, count, data.size()};
+    std::error_code ec;
+    std::filesystem::create_directories(OFFLINE_SPILL_DIR, ec);
+    if (!Durability::writeFile(segment.path, data)) {
+        UI::displayMessage("Error: Unable to spill offline changes to disk; keeping them in memory.");
+        return false;
+    }
+    return true;
 }
 
-void OfflineManager::queueDeleteRoom(const std::string& roomName, const std::string& adminName) {
-    std::ofstream offlineFile(OFFLINE_CHANGES_FILE, std::ios::app);
-    if (offlineFile.is_open()) {
-        offlineFile << "DELETE_ROOM " << roomName << " " << adminName << std::endl;
-        offlineFile.close();
-        UI::displayMessage("Offline action: Delete room '" + roomName + "' queued.");
-    } else {
-        UI::displayMessage("Error: Unable to save offline changes.");
+// Ops a checkpoint already covers are left out
+bool OfflineManager::readSegment(const SpillSegment& segment, std::vector<OfflineOp>& ops) {
+    ops.clear();
+    std::string data = readWholeFile(segment.path);
+    std::uint32_t count = 0, rawSize = 0, storedChecksum = 0;
+    std::uint64_t firstSeq = 0, lastSeq = 0;
+    std::string records;
+    if (!parseSegmentHeader(data, count, firstSeq, lastSeq, rawSize, storedChecksum)) {
+        return false;
+    }
+    std::string compressed = data.substr(SEGMENT_HEADER_SIZE);
+    if (checksum(compressed.data(), compressed.size()) != storedChecksum || !Compression::decompress(compressed, rawSize, records)) {
+        return false;
     }
+    std::size_t pos = 0;
+    OfflineOp op;
+    std::uint32_t read = 0;
+    while (readRecord(records, pos, op)) {
+        read++;
+        if (op.seq > appliedThrough) ops.push_back(op);
+    }
+    return read == count && pos == records.size();
 }
 
-void OfflineManager::queueBookRoom(const std::string& username, int participants, const std::string& roomName) {
-    std::ofstream offlineFile(OFFLINE_CHANGES_FILE, std::ios::app);
-    if (offlineFile.is_open()) {
-        offlineFile << "BOOK_ROOM " << username << " " << participants << " " << roomName << std::endl;
-        offlineFile.close();
-        UI::displayMessage("Offline action: Book room '" + roomName + "' for " + std::to_string(participants) + " queued.");
-    } else {
-        UI::displayMessage("Error: Unable to save offline changes.");
+void OfflineManager::recountQueueBytes() {
+    queueBytes = 0;
+    for (const auto& op : queue) {
+        queueBytes += footprint(op);
     }
 }
 
-void OfflineManager::queueReleaseRoom(const std::string& username, const std::string& roomName) {
-    std::ofstream offlineFile(OFFLINE_CHANGES_FILE, std::ios::app);
-    if (offlineFile.is_open()) {
-        offlineFile << "RELEASE_ROOM " << username << " " << roomName << std::endl;
-        offlineFile.close();
-        UI::displayMessage("Offline action: Release room '" + roomName + "' queued.");
-    } else {
+// Streams the spilled segments through the overlay one at a time
+void OfflineManager::rebuildOverlay() {
+    overlay.clear();
+    std::vector<OfflineOp> ops;
+    for (const auto& segment : segments) {
+        if (readSegment(segment, ops)) {
+            for (const auto& op : ops) overlay.apply(op);
+        }
+    }
+    for (const auto& op : queue) {
+        overlay.apply(op);
+    }
+}
+
+void OfflineManager::migrateLegacyQueue() {
+    std::ifstream legacyFile(OFFLINE_CHANGES_FILE);
+    if (!legacyFile.is_open()) {
+        return;
+    }
+    std::string records;
+    std::string line;
+    OfflineOp op;
+    while (std::getline(legacyFile, line)) {
+        if (parseLegacyLine(line, op)) {
+            records += encodeRecord(op);
+        }
+    }
+    legacyFile.close();
+    // Legacy actions were queued before anything in the binary log
+    if (!records.empty() && !Durability::writeFile(OFFLINE_QUEUE_LOG, records + readWholeFile(OFFLINE_QUEUE_LOG))) {
+        UI::displayMessage("Error: Unable to migrate offline changes.");
+        return;
+    }
+    std::remove(OFFLINE_CHANGES_FILE.c_str());
+}
+
+// The log append happens first, so an action is only queued once it is on disk.
+// Past the memory budget the oldest ops spill to disk; once the spill limit is
+// used up as well, new ops are refused.
+bool OfflineManager::enqueue(OfflineOp op) {
+    if (getQueuePressure() == QueuePressure::FULL) {
+        UI::displayMessage("Error: The offline queue is full. Go online to synchronize before making more changes.");
+        return false;
+    }
+    op.seq = nextSeq;
+    recordBase(op);
+    if (!Durability::append(OFFLINE_QUEUE_LOG, encodeRecord(op))) {
         UI::displayMessage("Error: Unable to save offline changes.");
+        return false;
     }
+    nextSeq++;
+    queue.push_back(op);
+    queueBytes += footprint(op);
+    overlay.apply(op);
+    queueVersion++;
+    if (queueBytes > memoryBudget && !replaying) {
+        spillOldest();
+    }
+    return true;
 }
 
+bool OfflineManager::queueUploadRoom(const std::string& adminName, const std::string& roomName, int capacity, bool isAvailable) {
+    OfflineOp op;
+    op.type = OfflineOp::Type::UPLOAD_ROOM;
+    op.actor = adminName;
+    op.target = roomName;
+    op.number = capacity;
+    op.flag = isAvailable;
+    if (!enqueue(op)) {
+        return false;
+    }
+    UI::displayMessage("Offline action: Upload room '" + roomName + "' queued.");
+    return true;
+}
+
+bool OfflineManager::queueModifyRoom(const std::string& adminName, const std::string& roomName, int capacity, bool isAvailable) {
+    OfflineOp op;
+    op.type = OfflineOp::Type::MODIFY_ROOM;
+    op.actor = adminName;
+    op.target = roomName;
+    op.number = capacity;
+    op.flag = isAvailable;
+    if (!enqueue(op)) {
+        return false;
+    }
+    UI::displayMessage("Offline action: Modify room '" + roomName + "' queued.");
+    return true;
+}
+
+bool OfflineManager::queueRegisterNewAdmin(const std::string& adminName, const std::string& newAdminUsername, const std::string& newAdminPassword) {
+    OfflineOp op;
+    op.type = OfflineOp::Type::REGISTER_NEW_ADMIN;
+    op.actor = adminName;
+    op.target = newAdminUsername;
+    op.secret = newAdminPassword;
+    if (!enqueue(op)) {
+        return false;
+    }
+    UI::displayMessage("Offline action: Register new admin '" + newAdminUsername + "' queued.");
+    return true;
+}
+
+bool OfflineManager::queueDeleteUser(const std::string& targetUsername) {
+    OfflineOp op;
+    op.type = OfflineOp::Type::DELETE_USER;
+    op.target = targetUsername;
+    if (!enqueue(op)) {
+        return false;
+    }
+    UI::displayMessage("Offline action: Delete user/admin '" + targetUsername + "' queued.");
+    return true;
+}
+
+bool OfflineManager::queueEditUser(const std::string& targetUsername, const std::string& newPassword, Authentication::Role newRole) {
+    OfflineOp op;
+    op.type = OfflineOp::Type::EDIT_USER;
+    op.target = targetUsername;
+    op.secret = newPassword;
+    op.role = newRole;
+    if (!enqueue(op)) {
+        return false;
+    }
+    UI::displayMessage("Offline action: Edit user/admin '" + targetUsername + "' queued.");
+    return true;
+}
+
+bool OfflineManager::queueDeleteRoom(const std::string& roomName, const std::string& adminName) {
+    OfflineOp op;
+    op.type = OfflineOp::Type::DELETE_ROOM;
+    op.actor = adminName;
+    op.target = roomName;
+    if (!enqueue(op)) {
+        return false;
+    }
+    UI::displayMessage("Offline action: Delete room '" + roomName + "' queued.");
+    return true;
+}
+
+bool OfflineManager::queueBookRoom(const std::string& username, int participants, const std::string& roomName) {
+    OfflineOp op;
+    op.type = OfflineOp::Type::BOOK_ROOM;
+    op.actor = username;
+    op.target = roomName;
+    op.number = participants;
+    if (!enqueue(op)) {
+        return false;
+    }
+    UI::displayMessage("Offline action: Book room '" + roomName + "' for " + std::to_string(participants) + " queued.");
+    return true;
+}
+
+bool OfflineManager::queueReleaseRoom(const std::string& username, const std::string& roomName) {
+    OfflineOp op;
+    op.type = OfflineOp::Type::RELEASE_ROOM;
+    op.actor = username;
+    op.target = roomName;
+    if (!enqueue(op)) {
+        return false;
+    }
+    UI::displayMessage("Offline action: Release room '" + roomName + "' queued.");
+    return true;
+}
+
+// Folds the queue into the shortest sequence with the same end state, so
+// replay cost follows the number of distinct rooms and users touched rather
+// than the raw number of queued actions. Every op is simulated against the
+// current rooms and accounts, and per key:
+//   - ops that would change nothing (failed bookings, duplicate uploads) drop out
+//   - consecutive MODIFY_ROOM or EDIT_USER ops keep only the last one
+//   - BOOK_ROOM then RELEASE_ROOM cancel when the room ends up as it started
+//   - a delete replaces everything queued before it, and disappears as well
+//     when the room or user did not exist to begin with
+// BOOK_ROOM without a room name picks from every room, so it is a barrier:
+// nothing is folded across it. Ops on the protected 'Chetan' account are
+// passed through unchanged.
+std::vector<OfflineOp> OfflineManager::compactQueue(const std::vector<OfflineOp>& ops) {
+    std::vector<bool> keep(ops.size(), true);
+
+    // Room shadow in RoomManager order, since best-fit booking breaks ties by position
+    std::unordered_map<std::string, RoomShadow> rooms;
+    std::vector<std::string> roomOrder;
+    for (const auto& room : rm.getRooms()) {
+        rooms[room.getName()] = RoomShadow{true, room.getCapacity(), room.isAvailable(), room.getBookedBy(), room.getLastModifiedBy()};
+        roomOrder.push_back(room.getName());
+    }
+    std::unordered_map<std::string, bool> userExists;
+
+    // Kept ops per key since the last barrier, each with the key's state before it
+    std::unordered_map<std::string, std::vector<std::size_t>> roomChains;
+    std::unordered_map<std::string, std::vector<std::size_t>> userChains;
+    std::vector<RoomShadow> roomBefore(ops.size());
+    std::vector<bool> userBefore(ops.size(), false);
+    // An op that absorbs earlier ones on its key keeps the earliest base
+    std::vector<std::size_t> baseFrom(ops.size());
+    for (std::size_t i = 0; i < ops.size(); ++i) baseFrom[i] = i;
+
+    for (std::size_t i = 0; i < ops.size(); ++i) {
+        const OfflineOp& op = ops[i];
+
+        if (op.type == OfflineOp::Type::BOOK_ROOM && op.target.empty()) {
+            std::string chosen;
+            int minCapacityDiff = INT_MAX;
+            for (const auto& name : roomOrder) {
+                const RoomShadow& room = rooms[name];
+                if (room.available && room.capacity >= op.number && room.capacity - op.number < minCapacityDiff) {
+                    minCapacityDiff = room.capacity - op.number;
+                    chosen = name;
+                }
+            }
+            if (chosen.empty()) {
+                keep[i] = false; // Nothing fits, so the booking would fail
+                continue;
+            }
+            rooms[chosen].available = false;
+            rooms[chosen].bookedBy = op.actor;
+            roomChains.clear();
+            continue;
+        }
+
+        if (isRoomOperation(op.type)) {
+            RoomShadow before = rooms.count(op.target) ? rooms[op.target] : RoomShadow{};
+            RoomShadow after = applyToRoom(op, before);
+            if (after == before) {
+                keep[i] = false;
+                continue;
+            }
+            if (!before.exists && after.exists) {
+                roomOrder.push_back(op.target);
+            } else if (before.exists && !after.exists) {
+                roomOrder.erase(std::find(roomOrder.begin(), roomOrder.end(), op.target));
+            }
+            rooms[op.target] = after;
+
+            std::vector<std::size_t>& chain = roomChains[op.target];
+            roomBefore[i] = before;
+            if (op.type == OfflineOp::Type::MODIFY_ROOM && !chain.empty() && ops[chain.back()].type == OfflineOp::Type::MODIFY_ROOM) {
+                roomBefore[i] = roomBefore[chain.back()];
+                baseFrom[i] = baseFrom[chain.back()];
+                keep[chain.back()] = false;
+                chain.pop_back();
+            } else if (op.type == OfflineOp::Type::DELETE_ROOM) {
+                RoomShadow initial = chain.empty() ? before : roomBefore[chain.front()];
+                if (!chain.empty()) baseFrom[i] = baseFrom[chain.front()];
+                for (std::size_t index : chain) keep[index] = false;
+                chain.clear();
+                if (!initial.exists) {
+                    keep[i] = false;
+                    continue;
+                }
+                roomBefore[i] = initial;
+            } else if (op.type == OfflineOp::Type::RELEASE_ROOM && !chain.empty() &&
+                       ops[chain.back()].type == OfflineOp::Type::BOOK_ROOM && roomBefore[chain.back()] == after) {
+                keep[chain.back()] = false;
+                chain.pop_back();
+                keep[i] = false;
+                continue;
+            }
+            chain.push_back(i);
+            continue;
+        }
+
+        // Account operations
+        if (op.target == "Chetan" && op.type != OfflineOp::Type::REGISTER_NEW_ADMIN) {
+            continue; // Rejected by Authentication on replay; left as queued
+        }
+        if (!userExists.count(op.target)) {
+            userExists[op.target] = auth.hasUser(op.target);
+        }
+        bool before = userExists[op.target];
+        std::vector<std::size_t>& chain = userChains[op.target];
+        userBefore[i] = before;
+        switch (op.type) {
+            case OfflineOp::Type::REGISTER_NEW_ADMIN:
+                if (before) {
+                    keep[i] = false;
+                    continue;
+                }
+                userExists[op.target] = true;
+                break;
+            case OfflineOp::Type::EDIT_USER:
+                if (!before) {
+                    keep[i] = false;
+                    continue;
+                }
+                if (!chain.empty() && ops[chain.back()].type == OfflineOp::Type::EDIT_USER) {
+                    userBefore[i] = userBefore[chain.back()];
+                    baseFrom[i] = baseFrom[chain.back()];
+                    keep[chain.back()] = false;
+                    chain.pop_back();
+                }
+                break;
+            case OfflineOp::Type::DELETE_USER: {
+                bool initial = chain.empty() ? before : userBefore[chain.front()];
+                if (!chain.empty()) baseFrom[i] = baseFrom[chain.front()];
+                for (std::size_t index : chain) keep[index] = false;
+                chain.clear();
+                userExists[op.target] = false;
+                if (!initial) {
+                    keep[i] = false;
+                    continue;
+                }
+                userBefore[i] = initial;
+                break;
+            }
+            default:
+                break;
+        }
+        chain.push_back(i);
+    }
+
+    std::vector<OfflineOp> compacted;
+    for (std::size_t i = 0; i < ops.size(); ++i) {
+        if (!keep[i]) continue;
+        compacted.push_back(ops[i]);
+        copyBase(ops[baseFrom[i]], compacted.back());
+    }
+    return compacted;
+}
+
+// Replay runs in phases of up to REPLAY_PHASE_LIMIT ops. A phase ends before
+// the next BOOK_ROOM without a room name, which reads every room and so runs
+// on its own, and before a second UPLOAD_ROOM, since uploads decide the order
+// of rooms in RoomManager. Inside a phase the ops are grouped by key (room or
+// account) and the groups run in parallel on a pool, each one in queue order.
+// Rooms are only changed in place while groups run; uploads and deletes move
+// other rooms around in RoomManager and take roomStructure exclusively.
+//
+// When someone waits in acquireState(), the workers are parked between ops
+// and the state lock is handed over, so a UI thread locking once per frame
+// keeps rendering while a long queue is replayed.
+//
+// Spilled segments are replayed before the in-memory queue, one at a time, so
+// a sync never holds more than one segment's ops on top of the budget.
+//
+// The compacted queue replaces the log up front; actions queued meanwhile are
+// appended behind it and wait for the next sync. Once at least a phase limit
+// of ops is done, the batches are closed and what they wrote is committed in
+// one Durability transaction together with a checkpoint naming the last
+// applied op. After a crash loadQueue() resumes right behind the checkpoint,
+// and the state on disk is exactly what the ops up to it produced, so none of
+// them is applied twice; ops after it were never persisted and run again.
+//
+// Before an op is applied its base version is compared with the target's
+// current one. Ops queued together on one key share a base, so once an op is
+// applied the key's base is mapped to the version it produced; a later op with
+// the same base then only conflicts if something else changed the key since.
+// After a crash that mapping is gone, and such follow-up ops are reported as
+// conflicts rather than applied unchecked.
 void OfflineManager::synchronizeChanges() {
-    std::ifstream offlineFile(OFFLINE_CHANGES_FILE);
-    if (!offlineFile.is_open()) {
+    std::unique_lock<std::mutex> lock(stateMutex);
+    if (queue.empty() && segments.empty()) {
         UI::displayMessage("No offline changes to synchronize.");
         return;
     }
 
     UI::displayMessage("Synchronizing offline changes...");
-    std::string line;
-    while (std::getline(offlineFile, line)) {
-        std::stringstream ss(line);
-        std::string action;
-        ss >> action;
-
-        if (action == "UPLOAD_ROOM") {
-            std::string adminName, roomName, isAvailable_str;
-            int capacity;
-            ss >> adminName >> roomName >> capacity >> isAvailable_str;
-            applyUploadRoom(adminName, roomName, capacity, isAvailable_str == "Yes");
-        } else if (action == "MODIFY_ROOM") {
-            std::string adminName, roomName, isAvailable_str;
-            int capacity;
-            ss >> adminName >> roomName >> capacity >> isAvailable_str;
-            applyModifyRoom(adminName, roomName, capacity, isAvailable_str == "Yes");
-        } else if (action == "REGISTER_NEW_ADMIN") {
-            std::string adminName, newAdminUsername, newAdminPassword;
-            ss >> adminName >> newAdminUsername >> newAdminPassword;
-            applyRegisterNewAdmin(adminName, newAdminUsername, newAdminPassword);
-        } else if (action == "BOOK_ROOM") {
-            std::string username, roomName;
-            int participants;
-            ss >> username >> participants >> roomName;
-            applyBookRoom(username, participants, roomName);
-        } else if (action == "DELETE_USER") {
-            std::string targetUsername;
-            ss >> targetUsername;
-            applyDeleteUser(targetUsername);
-        } else if (action == "EDIT_USER") {
-            std::string targetUsername, newPassword, newRoleStr;
-            ss >> targetUsername >> newPassword >> newRoleStr;
-            Authentication::Role newRole = (newRoleStr == "ADMIN") ? Authentication::Role::ADMIN : Authentication::Role::USER;
-            applyEditUser(targetUsername, newPassword, newRole); // This line was missing the call to applyEditUser
-        } else if (action == "RELEASE_ROOM") {
-            std::string username, roomName;
-            ss >> username >> roomName;
-            applyReleaseRoom(username, roomName);
-        } else if (action == "DELETE_ROOM") {
-            std::string roomName, adminName;
-            ss >> roomName >> adminName;
-            applyDeleteRoom(roomName, adminName);
-        }
-    }
-
-    offlineFile.close();
-    std::ofstream clearOffline(OFFLINE_CHANGES_FILE, std::ofstream::out | std::ofstream::trunc);
-    clearOffline.close();
-
-    UI::displayMessage("Offline changes have been synchronized successfully.");
+    replaying = true;
+    syncApplied = 0;
+    syncTotal = spilledOps + queue.size();
+    lastConflicts.clear();
+    std::unordered_map<std::string, KeyState> keys;
+    std::size_t applied = 0;
+    bool keepCheckpoint = false;
+
+    // Spilled segments first, oldest first, each compacted and replayed on its
+    // own; a segment is deleted once done, or rewritten with what a cancel left
+    while (!segments.empty() && !cancelRequested) {
+        SpillSegment segment = segments.front();
+        segments.erase(segments.begin());
+        spilledOps -= segment.count;
+        spilledBytes -= segment.bytes;
+        std::vector<OfflineOp> ops;
+        if (!readSegment(segment, ops)) {
+            UI::displayMessage("Warning: Skipped a damaged offline spill segment: " + segment.path);
+            std::error_code ec;
+            std::filesystem::rename(segment.path, segment.path + ".damaged", ec);
+            syncTotal -= segment.count;
+            continue;
+        }
+        std::vector<OfflineOp> compacted = compactQueue(ops);
+        syncTotal -= segment.count - compacted.size();
+        std::vector<char> done(compacted.size(), 0);
+        replayOps(compacted, compacted.size(), done, std::vector<std::uint64_t>(compacted.size(), 0), keys, lock);
+        applied += static_cast<std::size_t>(std::count(done.begin(), done.end(), 1));
+
+        std::vector<OfflineOp> remaining;
+        for (std::size_t i = 0; i < compacted.size(); ++i) {
+            if (!done[i]) remaining.push_back(compacted[i]);
+        }
+        SpillSegment rest;
+        if (!remaining.empty()) {
+            if (!writeSegment(remaining, remaining.size(), rest)) {
+                // The checkpoint written by replayOps() still marks how far this segment got
+                rest = segment;
+                keepCheckpoint = true;
+                std::size_t prefix = 0;
+                while (prefix < done.size() && done[prefix]) prefix++;
+                if (prefix > 0) appliedThrough = compacted[prefix - 1].seq;
+            }
+            segments.insert(segments.begin(), rest);
+            spilledOps += rest.count;
+            spilledBytes += rest.bytes;
+        }
+        if (remaining.empty() || rest.path != segment.path) {
+            std::remove(segment.path.c_str());
+        }
+        queueVersion++;
+    }
+
+    if (segments.empty() && !queue.empty() && !cancelRequested) {
+        std::size_t taken = queue.size();
+        std::vector<OfflineOp> compacted = compactQueue(queue);
+        if (compacted.size() < taken) {
+            UI::displayMessage("Folded " + std::to_string(taken) + " queued actions into " + std::to_string(compacted.size()) + ".");
+            queue.swap(compacted);
+            syncTotal -= taken - queue.size();
+            queueVersion++;
+        }
+        std::vector<std::uint64_t> offsets = rewriteLog();
+        std::size_t total = queue.size(); // Ops queued while this sync runs are left for the next one
+        std::vector<char> done(total, 0);
+        replayOps(queue, total, done, offsets, keys, lock);
+        applied += static_cast<std::size_t>(std::count(done.begin(), done.end(), 1));
+
+        std::vector<OfflineOp> remaining;
+        for (std::size_t i = 0; i < queue.size(); ++i) {
+            if (i >= total || !done[i]) remaining.push_back(queue[i]);
+        }
+        queue.swap(remaining);
+        queueVersion++;
+        rewriteLog();
+    }
+    replaying = false;
+    if (!keepCheckpoint) {
+        std::remove(SYNC_CHECKPOINT_FILE.c_str());
+    }
+    recountQueueBytes();
+    if (queueBytes > memoryBudget) {
+        spillOldest(); // Ops queued during a long sync
+    }
+    // Applied ops are now in the real state; whatever is left is projected again on top of it
+    if (queue.empty() && segments.empty()) {
+        overlay.clear();
+    } else {
+        rebuildOverlay();
+    }
+
+    if (!lastConflicts.empty()) {
+        std::ostringstream report;
+        for (const auto& conflict : lastConflicts) {
+            report << conflict.operation << " | base v" << conflict.baseVersion << " current v" << conflict.currentVersion << " | "
+                   << conflict.resolution << "\n";
+        }
+        Durability::writeFile(SYNC_CONFLICTS_FILE, report.str());
+        UI::displayMessage(std::to_string(lastConflicts.size()) + " queued actions conflicted with newer changes; see " + SYNC_CONFLICTS_FILE + ".");
+    }
+
+    if (applied < syncTotal) {
+        UI::displayMessage("Synchronization cancelled; " + std::to_string(syncTotal - applied) + " actions remain queued.");
+    } else {
+        UI::displayMessage("Offline changes have been synchronized successfully.");
+    }
+}
+
+void OfflineManager::replayOps(std::vector<OfflineOp>& ops, std::size_t total, std::vector<char>& done, const std::vector<std::uint64_t>& offsets,
+                               std::unordered_map<std::string, KeyState>& keys, std::unique_lock<std::mutex>& lock) {
+    // Workers only start an op while the gate is open
+    std::mutex gateMutex;
+    std::condition_variable gate;
+    bool paused = false;
+    std::size_t inFlight = 0;
+    std::size_t tasksLeft = 0;
+    ThreadPool pool(replayThreads > 0 ? replayThreads.load() : ThreadPool::defaultThreadCount()); // Joined before the gate goes away
+
+    // Everything between checkpoints is applied in memory; rooms.txt, the user
+    // journal and both history logs are written when the batches close
+    auto beginBatches = [this]() {
+        rm.beginBatch();
+        rbs.beginBatch();
+        auth.beginBatch();
+    };
+    auto endBatches = [this]() {
+        auth.endBatch();
+        rbs.endBatch();
+        rm.endBatch();
+    };
+    auto commitPhase = []() {
+        if (!Durability::commitTransaction()) {
+            UI::displayMessage("Error: Unable to save synchronization progress.");
+        }
+    };
+    auto handOverState = [&]() {
+        // std::mutex is not fair; step aside until the waiter actually has the lock
+        lock.unlock();
+        while (stateWaiters > 0) {
+            std::this_thread::yield();
+        }
+        lock.lock();
+    };
+
+    // The password KDF runs on the auth pool before anything is applied, with
+    // the state lock released, so no one waiting for the lock sits behind a hash
+    std::vector<std::string> passwordHashes(total);
+    std::vector<std::pair<std::size_t, std::future<std::string>>> hashing;
+    for (std::size_t i = 0; i < total; ++i) {
+        if (ops[i].type == OfflineOp::Type::REGISTER_NEW_ADMIN) {
+            hashing.emplace_back(i, auth.hashPasswordAsync(ops[i].secret, Authentication::Role::ADMIN));
+        } else if (ops[i].type == OfflineOp::Type::EDIT_USER) {
+            hashing.emplace_back(i, auth.hashPasswordAsync(ops[i].secret, ops[i].role));
+        }
+    }
+    if (!hashing.empty()) {
+        lock.unlock();
+        for (auto& pending : hashing) {
+            passwordHashes[pending.first] = pending.second.get();
+        }
+        lock.lock();
+    }
+
+    beginBatches();
+    std::size_t next = 0;
+    std::size_t checkpointed = 0;
+    while (next < total && !cancelRequested) {
+        if (isAnyRoomBooking(ops[next])) {
+            applyOperation(ops[next], passwordHashes[next]);
+            done[next++] = 1;
+            syncApplied++;
+            if (stateWaiters > 0) {
+                handOverState();
+            }
+        } else {
+            std::vector<std::vector<std::size_t>> groups;
+            std::vector<KeyState*> groupKeys;
+            std::unordered_map<std::string, std::size_t> groupOf;
+            std::size_t end = next;
+            bool phaseUploads = false;
+            while (end < total && end - next < REPLAY_PHASE_LIMIT && !isAnyRoomBooking(ops[end])) {
+                if (ops[end].type == OfflineOp::Type::UPLOAD_ROOM) {
+                    if (phaseUploads) break;
+                    phaseUploads = true;
+                }
+                std::string key = keyFor(ops[end]);
+                auto inserted = groupOf.emplace(key, groups.size());
+                if (inserted.second) {
+                    groups.emplace_back();
+                    groupKeys.push_back(&keys[key]);
+                }
+                groups[inserted.first->second].push_back(end++);
+            }
+
+            // A few tasks per thread, each taking every taskCount-th group
+            std::size_t taskCount = std::min(groups.size(), pool.size() * 4);
+            std::vector<std::vector<SyncConflict>> taskConflicts(taskCount);
+            tasksLeft = taskCount;
+            for (std::size_t task = 0; task < taskCount; ++task) {
+                pool.submit([&, task]() {
+                    for (std::size_t group = task; group < groups.size(); group += taskCount) {
+                        for (std::size_t index : groups[group]) {
+                            {
+                                std::unique_lock<std::mutex> gateLock(gateMutex);
+                                gate.wait(gateLock, [&]() { return !paused; });
+                                if (cancelRequested) break;
+                                inFlight++;
+                            }
+                            replayOperation(ops[index], passwordHashes[index], *groupKeys[group], taskConflicts[task]);
+                            done[index] = 1;
+                            syncApplied++;
+                            {
+                                std::lock_guard<std::mutex> gateLock(gateMutex);
+                                inFlight--;
+                            }
+                            gate.notify_all();
+                        }
+                    }
+                    {
+                        std::lock_guard<std::mutex> gateLock(gateMutex);
+                        tasksLeft--;
+                    }
+                    gate.notify_all();
+                });
+            }
+
+            std::unique_lock<std::mutex> gateLock(gateMutex);
+            while (tasksLeft > 0) {
+                if (stateWaiters > 0) {
+                    paused = true;
+                    gate.wait(gateLock, [&]() { return inFlight == 0; });
+                    gateLock.unlock();
+                    handOverState();
+                    gateLock.lock();
+                    paused = false;
+                    gate.notify_all();
+                } else {
+                    gate.wait_for(gateLock, std::chrono::milliseconds(1), [&]() { return tasksLeft == 0; });
+                }
+            }
+            gateLock.unlock();
+            for (auto& conflicts : taskConflicts) {
+                lastConflicts.insert(lastConflicts.end(), conflicts.begin(), conflicts.end());
+            }
+            next = end;
+        }
+        if (next - checkpointed >= REPLAY_PHASE_LIMIT && next < total && !cancelRequested) {
+            Durability::beginTransaction();
+            endBatches();
+            writeCheckpoint(ops[next - 1].seq, offsets[next - 1]);
+            commitPhase();
+            checkpointed = next;
+            beginBatches();
+        }
+    }
+
+    Durability::beginTransaction();
+    endBatches();
+    // A cancel inside a phase can leave gaps; only the fully applied prefix is
+    // checkpointed. It covers the window until the shortened log is in place.
+    std::size_t prefix = checkpointed;
+    while (prefix < total && done[prefix]) prefix++;
+    if (prefix > checkpointed) {
+        writeCheckpoint(ops[prefix - 1].seq, offsets[prefix - 1]);
+    }
+    commitPhase();
+}
+
+// Runs on a replay worker; the key state belongs to this op's group only
+void OfflineManager::replayOperation(OfflineOp op, const std::string& passwordHash, KeyState& key, std::vector<SyncConflict>& conflicts) {
+    std::shared_lock<std::shared_mutex> shared(roomStructure, std::defer_lock);
+    std::unique_lock<std::shared_mutex> exclusive(roomStructure, std::defer_lock);
+    if (op.type == OfflineOp::Type::UPLOAD_ROOM || op.type == OfflineOp::Type::DELETE_ROOM) {
+        exclusive.lock();
+    } else if (isRoomOperation(op.type)) {
+        shared.lock();
+    }
+
+    std::uint64_t expected = key.adopted && key.base == op.baseVersion ? key.version : op.baseVersion;
+    std::uint64_t current = currentVersion(op);
+    if (current != expected) {
+        std::string resolution;
+        bool apply = resolveConflict(op, current, resolution);
+        OfflineOp shown = op;
+        if (!shown.secret.empty()) shown.secret = "****";
+        conflicts.push_back({shown.describe(), op.baseVersion, current, resolution});
+        if (!apply) {
+            return;
+        }
+    }
+    applyOperation(op, passwordHash);
+    key.adopted = true;
+    key.base = op.baseVersion;
+    key.version = currentVersion(op);
+}
+
+void OfflineManager::setReplayThreads(std::size_t threads) {
+    replayThreads = threads;
+}
+
+std::uint64_t OfflineManager::currentVersion(const OfflineOp& op) {
+    return isRoomOperation(op.type) ? rm.getRoomVersion(op.target) : auth.getUserVersion(op.target);
+}
+
+// Stamps the op with the state of its target at the time it is queued
+void OfflineManager::recordBase(OfflineOp& op) {
+    if (isRoomOperation(op.type)) {
+        Room* room = op.target.empty() ? nullptr : rm.findRoom(op.target);
+        if (room) {
+            op.baseVersion = room->getVersion();
+            op.baseNumber = room->getCapacity();
+            op.baseFlag = room->isAvailable();
+        }
+    } else {
+        op.baseVersion = auth.getUserVersion(op.target);
+        auth.getUserRole(op.target, op.baseRole);
+    }
+}
+
+// Returns whether the (possibly adjusted) op should still be applied
+bool OfflineManager::resolveConflict(OfflineOp& op, std::uint64_t current, std::string& resolution) {
+    switch (conflictPolicy.load()) {
+        case ConflictPolicy::REJECT:
+            resolution = "rejected";
+            return false;
+        case ConflictPolicy::LAST_WRITER_WINS:
+            resolution = "applied over the newer change";
+            return true;
+        case ConflictPolicy::MERGE:
+            break;
+    }
+    if (op.type == OfflineOp::Type::DELETE_ROOM || op.type == OfflineOp::Type::DELETE_USER) {
+        resolution = current == 0 ? "already deleted" : "kept the changed " + std::string(op.type == OfflineOp::Type::DELETE_ROOM ? "room" : "account");
+        return false;
+    }
+    if (op.type == OfflineOp::Type::MODIFY_ROOM) {
+        Room* room = rm.findRoom(op.target);
+        if (!room) {
+            resolution = "room no longer exists";
+            return false;
+        }
+        // Three-way per field: a field only the queued op changed takes its value, anything else keeps the current one
+        bool capacityChanged = op.number != op.baseNumber;
+        bool availabilityChanged = op.flag != op.baseFlag;
+        bool capacityClash = capacityChanged && room->getCapacity() != op.baseNumber && room->getCapacity() != op.number;
+        bool availabilityClash = availabilityChanged && room->isAvailable() != op.baseFlag && room->isAvailable() != op.flag;
+        if (!capacityChanged || capacityClash) op.number = room->getCapacity();
+        if (!availabilityChanged || availabilityClash) op.flag = room->isAvailable();
+        resolution = "merged";
+        if (capacityClash) resolution += "; kept current capacity " + std::to_string(room->getCapacity());
+        if (availabilityClash) resolution += "; kept current availability";
+        return true;
+    }
+    if (op.type == OfflineOp::Type::EDIT_USER) {
+        Authentication::Role currentRole;
+        if (!auth.getUserRole(op.target, currentRole)) {
+            resolution = "account no longer exists";
+            return false;
+        }
+        if (op.role == op.baseRole || (currentRole != op.baseRole && currentRole != op.role)) {
+            op.role = currentRole; // Role changed elsewhere only (or on both sides): keep it, still set the password
+        }
+        resolution = "merged";
+        return true;
+    }
+    // Uploads, registrations, bookings and releases check the current state themselves
+    resolution = "applied against the current state";
+    return true;
+}
+
+// Returns where each queued op's record starts in the new log
+std::vector<std::uint64_t> OfflineManager::rewriteLog() {
+    std::string records;
+    std::vector<std::uint64_t> offsets;
+    offsets.reserve(queue.size());
+    for (const auto& op : queue) {
+        offsets.push_back(records.size());
+        records += encodeRecord(op);
+    }
+    if (!Durability::writeFile(OFFLINE_QUEUE_LOG, records)) {
+        UI::displayMessage("Error: Unable to save offline changes.");
+    }
+    return offsets;
+}
+
+bool OfflineManager::writeCheckpoint(std::uint64_t seq, std::uint64_t offset) {
+    if (!Durability::writeFile(SYNC_CHECKPOINT_FILE, std::to_string(seq) + " " + std::to_string(offset) + "\n")) {
+        UI::displayMessage("Error: Unable to save synchronization progress.");
+        return false;
+    }
+    return true;
+}
+
+void OfflineManager::applyOperation(const OfflineOp& op, const std::string& passwordHash) {
+    switch (op.type) {
+        case OfflineOp::Type::UPLOAD_ROOM:
+            applyUploadRoom(op.actor, op.target, op.number, op.flag);
+            break;
+        case OfflineOp::Type::MODIFY_ROOM:
+            applyModifyRoom(op.actor, op.target, op.number, op.flag);
+            break;
+        case OfflineOp::Type::REGISTER_NEW_ADMIN:
+            applyRegisterNewAdmin(op.actor, op.target, passwordHash);
+            break;
+        case OfflineOp::Type::BOOK_ROOM:
+            applyBookRoom(op.actor, op.number, op.target);
+            break;
+        case OfflineOp::Type::DELETE_USER:
+            applyDeleteUser(op.target);
+            break;
+        case OfflineOp::Type::EDIT_USER:
+            applyEditUser(op.target, passwordHash, op.role);
+            break;
+        case OfflineOp::Type::DELETE_ROOM:
+            applyDeleteRoom(op.target, op.actor);
+            break;
+        case OfflineOp::Type::RELEASE_ROOM:
+            applyReleaseRoom(op.actor, op.target);
+            break;
+    }
 }
 
 void OfflineManager::applyUploadRoom(const std::string& adminName, const std::string& roomName, int capacity, bool isAvailable) {
@@ -181,8 +1396,8 @@ void OfflineManager::applyModifyRoom(const std::string& adminName, const std::st
     rm.modifyRoom(adminName, roomName, capacity, isAvailable);
 }
 
-void OfflineManager::applyRegisterNewAdmin(const std::string& /*adminName*/, const std::string& newAdminUsername, const std::string& newAdminPassword) {
-    auth.registerAdmin(newAdminUsername, newAdminPassword);
+void OfflineManager::applyRegisterNewAdmin(const std::string& /*adminName*/, const std::string& newAdminUsername, const std::string& passwordHash) {
+    auth.completeRegister(newAdminUsername, passwordHash, Authentication::Role::ADMIN);
 }
 
 void OfflineManager::applyBookRoom(const std::string& username, int participants, const std::string& roomName) {
@@ -197,23 +1412,66 @@ void OfflineManager::applyDeleteUser(const std::string& targetUsername) {
     auth.deleteUser(targetUsername);
 }
 
-void OfflineManager::applyEditUser(const std::string& targetUsername, const std::string& newPassword, Authentication::Role newRole) {
-    auth.editUser(targetUsername, newPassword, newRole);
+void OfflineManager::applyEditUser(const std::string& targetUsername, const std::string& passwordHash, Authentication::Role newRole) {
+    auth.completeEditUser(targetUsername, passwordHash, newRole);
 }
 
 void OfflineManager::applyReleaseRoom(const std::string& username, const std::string& roomName) {
     rbs.releaseRoom(username, roomName, false);
 }
 
-std::vector<std::string> OfflineManager::getQueueForDisplay() {
-    std::vector<std::string> queue;
-    std::ifstream offlineFile(OFFLINE_CHANGES_FILE);
-    if (offlineFile.is_open()) {
-        std::string line;
-        while (std::getline(offlineFile, line)) {
-            queue.push_back(line);
+const std::vector<std::string>& OfflineManager::getQueueForDisplay() {
+    if (displayVersion != queueVersion) {
+        displayCache.clear();
+        displayCache.reserve(queue.size() + 1);
+        if (!segments.empty()) {
+            displayCache.push_back("(" + std::to_string(spilledOps) + " earlier actions spilled to disk in " + std::to_string(segments.size()) +
+                                   " segments)");
+        }
+        for (const auto& op : queue) {
+            displayCache.push_back(op.describe());
         }
-        offlineFile.close();
+        displayVersion = queueVersion;
+    }
+    return displayCache;
+}
+
+const std::vector<Room>& OfflineManager::getProjectedRooms() {
+    return overlay.getRooms();
+}
+
+const Room* OfflineManager::findProjectedRoom(const std::string& roomName) {
+    return overlay.findRoom(roomName);
+}
+
+bool OfflineManager::findProjectedUser(const std::string& username, Authentication::Role& role) {
+    return overlay.findUser(username, role);
+}
+
+std::uint64_t OfflineManager::getProjectedVersion() const {
+    return overlay.getVersion();
+}
+
+std::uint64_t OfflineManager::getQueueVersion() const {
+    return queueVersion;
+}
+
+void OfflineManager::setQueueBudget(std::size_t memoryBytes, std::size_t spillLimitBytes) {
+    memoryBudget = memoryBytes;
+    spillLimit = spillLimitBytes;
+    if (queueBytes > memoryBudget && !replaying) {
+        spillOldest();
+    }
+}
+
+OfflineManager::QueueMetrics OfflineManager::getQueueMetrics() const {
+    return QueueMetrics{spilledOps + queue.size(), queue.size(), queueBytes, memoryBudget, spilledOps, segments.size(), spilledBytes,
+                        spillLimit, getQueuePressure()};
+}
+
+OfflineManager::QueuePressure OfflineManager::getQueuePressure() const {
+    if (queueBytes >= memoryBudget && spilledBytes >= spillLimit) {
+        return QueuePressure::FULL;
     }
-    return queue;
-}
\ No newline at end of file
+    return segments.empty() ? QueuePressure::NORMAL : QueuePressure::SPILLING;
+}
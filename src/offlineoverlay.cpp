@@ -0,0 +1,198 @@
+#include "offlineoverlay.hpp"
+#include "offlinemechanism.hpp"
+#include <algorithm>
+#include <climits>
+#include <ctime>
+
+OfflineOverlay::OfflineOverlay(RoomManager& rm, Authentication& auth)
+    : rm(rm), auth(auth), version(1), cachedVersion(0), cachedRoomsVersion(0) {}
+
+// Copy-on-write: the first op on a room takes a copy of its real state
+OfflineOverlay::RoomEntry& OfflineOverlay::touchRoom(const std::string& roomName) {
+    auto it = rooms.find(roomName);
+    if (it != rooms.end()) {
+        return it->second;
+    }
+    RoomEntry entry;
+    if (const Room* room = rm.findRoom(roomName)) {
+        entry.room = *room;
+    }
+    return rooms.emplace(roomName, std::move(entry)).first->second;
+}
+
+std::optional<Authentication::Role>& OfflineOverlay::touchUser(const std::string& username) {
+    auto it = users.find(username);
+    if (it != users.end()) {
+        return it->second;
+    }
+    std::optional<Authentication::Role> entry;
+    Authentication::Role role;
+    if (auth.getUserRole(username, role)) {
+        entry = role;
+    }
+    return users.emplace(username, entry).first->second;
+}
+
+template <typename Visit>
+void OfflineOverlay::forEachRoom(Visit visit) {
+    for (const auto& room : rm.getRooms()) {
+        auto it = rooms.find(room.getName());
+        if (it == rooms.end()) {
+            visit(room);
+        } else if (it->second.room && !it->second.appended) {
+            visit(*it->second.room);
+        }
+    }
+    for (const auto& name : appendedOrder) {
+        visit(*rooms[name].room);
+    }
+}
+
+// Mirrors what RoomManager, RoomBookingSystem and Authentication do on sync.
+void OfflineOverlay::apply(const OfflineOp& op) {
+    switch (op.type) {
+        case OfflineOp::Type::UPLOAD_ROOM: {
+            RoomEntry& entry = touchRoom(op.target);
+            if (!entry.room) {
+                entry.room = Room(op.target, op.actor, op.number, op.flag);
+                entry.room->setVersion(PROJECTED_STAMP | version);
+                if (!entry.appended) {
+                    entry.appended = true;
+                    appendedOrder.push_back(op.target);
+                }
+            }
+            break;
+        }
+        case OfflineOp::Type::MODIFY_ROOM: {
+            RoomEntry& entry = touchRoom(op.target);
+            if (entry.room) {
+                entry.room->setCapacity(op.number);
+                entry.room->setAvailable(op.flag);
+                entry.room->setLastModifiedBy(op.actor);
+                entry.room->setTimestamp(time(0));
+                entry.room->setVersion(PROJECTED_STAMP | version);
+            }
+            break;
+        }
+        case OfflineOp::Type::DELETE_ROOM: {
+            RoomEntry& entry = touchRoom(op.target);
+            entry.room.reset();
+            if (entry.appended) {
+                // A later upload appends it again, like RoomManager does
+                entry.appended = false;
+                appendedOrder.erase(std::find(appendedOrder.begin(), appendedOrder.end(), op.target));
+            }
+            break;
+        }
+        case OfflineOp::Type::BOOK_ROOM:
+            if (!op.target.empty()) {
+                applyBooking(op, op.target);
+            } else {
+                // Best fit over the projected rooms, first one wins ties
+                const Room* chosen = nullptr;
+                int minCapacityDiff = INT_MAX;
+                forEachRoom([&](const Room& room) {
+                    if (room.isAvailable() && room.getCapacity() >= op.number && room.getCapacity() - op.number < minCapacityDiff) {
+                        minCapacityDiff = room.getCapacity() - op.number;
+                        chosen = &room;
+                    }
+                });
+                if (chosen) {
+                    applyBooking(op, chosen->getName());
+                }
+            }
+            break;
+        case OfflineOp::Type::RELEASE_ROOM: {
+            RoomEntry& entry = touchRoom(op.target);
+            if (entry.room && !entry.room->isAvailable() && entry.room->getBookedBy() == op.actor) {
+                entry.room->setAvailable(true);
+                entry.room->setBookedBy("");
+                entry.room->setVersion(PROJECTED_STAMP | version);
+            }
+            break;
+        }
+        case OfflineOp::Type::REGISTER_NEW_ADMIN: {
+            std::optional<Authentication::Role>& user = touchUser(op.target);
+            if (!user) {
+                user = Authentication::Role::ADMIN;
+            }
+            break;
+        }
+        case OfflineOp::Type::DELETE_USER:
+            if (op.target != "Chetan") {
+                touchUser(op.target).reset();
+            }
+            break;
+        case OfflineOp::Type::EDIT_USER: {
+            std::optional<Authentication::Role>& user = touchUser(op.target);
+            if (user && op.target != "Chetan") {
+                user = op.role;
+            }
+            break;
+        }
+    }
+    version++;
+}
+
+void OfflineOverlay::applyBooking(const OfflineOp& op, const std::string& roomName) {
+    RoomEntry& entry = touchRoom(roomName);
+    if (entry.room && entry.room->isAvailable() && entry.room->getCapacity() >= op.number) {
+        entry.room->setAvailable(false);
+        entry.room->setBookedBy(op.actor);
+        entry.room->setVersion(PROJECTED_STAMP | version);
+    }
+}
+
+void OfflineOverlay::rebuild(const std::vector<OfflineOp>& ops) {
+    clear();
+    for (const auto& op : ops) {
+        apply(op);
+    }
+}
+
+void OfflineOverlay::clear() {
+    rooms.clear();
+    appendedOrder.clear();
+    users.clear();
+    version++;
+}
+
+bool OfflineOverlay::empty() const {
+    return rooms.empty() && users.empty();
+}
+
+const Room* OfflineOverlay::findRoom(const std::string& roomName) {
+    auto it = rooms.find(roomName);
+    if (it == rooms.end()) {
+        return rm.findRoom(roomName);
+    }
+    return it->second.room ? &*it->second.room : nullptr;
+}
+
+bool OfflineOverlay::findUser(const std::string& username, Authentication::Role& role) {
+    auto it = users.find(username);
+    if (it == users.end()) {
+        return auth.getUserRole(username, role);
+    }
+    if (!it->second) {
+        return false;
+    }
+    role = *it->second;
+    return true;
+}
+
+const std::vector<Room>& OfflineOverlay::getRooms() {
+    if (cachedVersion == version && cachedRoomsVersion == rm.getVersion()) {
+        return roomsCache;
+    }
+    roomsCache.clear();
+    roomsCache.reserve(rm.getRooms().size() + appendedOrder.size());
+    forEachRoom([this](const Room& room) { roomsCache.push_back(room); });
+    cachedVersion = version;
+    cachedRoomsVersion = rm.getVersion();
+    return roomsCache;
+}
+
+std::uint64_t OfflineOverlay::getVersion() const {
+    return version;
+}
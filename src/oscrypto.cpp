@@ -0,0 +1,25 @@
+#include "oscrypto.hpp"
+#include <cstdio>
+#include <stdexcept>
+
+#ifdef _WIN32
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <bcrypt.h>
+#endif
+
+void OsCrypto::fillRandom(std::uint8_t* buffer, std::size_t length) {
+#ifdef _WIN32
+    bool filled = BCryptGenRandom(nullptr, buffer, static_cast<ULONG>(length), BCRYPT_USE_SYSTEM_PREFERRED_RNG) >= 0;
+#else
+    bool filled = false;
+    if (std::FILE* source = std::fopen("/dev/urandom", "rb")) {
+        filled = std::fread(buffer, 1, length, source) == length;
+        std::fclose(source);
+    }
+#endif
+    if (!filled) {
+        throw std::runtime_error("OS random source unavailable");
+    }
+}
@@ -0,0 +1,336 @@
+#include "passwordhash.hpp"
+#include "oscrypto.hpp"
+#include <algorithm>
+#include <cstring>
+#include <functional>
+
+namespace {
+
+const std::uint32_t SHA256_K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+inline std::uint32_t rotr(std::uint32_t x, int n) { return (x >> n) | (x << (32 - n)); }
+inline std::uint32_t rotl(std::uint32_t x, int n) { return (x << n) | (x >> (32 - n)); }
+
+class Sha256 {
+public:
+    Sha256() { reset(); }
+
+    void reset() {
+        const std::uint32_t init[8] = { 0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19 };
+        std::memcpy(state, init, sizeof(state));
+        totalLength = 0;
+        bufferLength = 0;
+    }
+
+    void update(const std::uint8_t* data, std::size_t length) {
+        totalLength += length;
+        while (length > 0) {
+            std::size_t take = std::min<std::size_t>(64 - bufferLength, length);
+            std::memcpy(buffer + bufferLength, data, take);
+            bufferLength += take;
+            data += take;
+            length -= take;
+            if (bufferLength == 64) {
+                transform(buffer);
+                bufferLength = 0;
+            }
+        }
+    }
+
+    void finish(std::uint8_t out[32]) {
+        std::uint64_t bitLength = totalLength * 8;
+        std::uint8_t pad = 0x80;
+        update(&pad, 1);
+        std::uint8_t zero = 0;
+        while (bufferLength != 56) update(&zero, 1);
+        std::uint8_t lengthBytes[8];
+        for (int i = 0; i < 8; ++i) lengthBytes[i] = static_cast<std::uint8_t>(bitLength >> (56 - 8 * i));
+        update(lengthBytes, 8);
+        for (int i = 0; i < 8; ++i) {
+            out[4 * i] = static_cast<std::uint8_t>(state[i] >> 24);
+            out[4 * i + 1] = static_cast<std::uint8_t>(state[i] >> 16);
+            out[4 * i + 2] = static_cast<std::uint8_t>(state[i] >> 8);
+            out[4 * i + 3] = static_cast<std::uint8_t>(state[i]);
+        }
+    }
+
+private:
+    std::uint32_t state[8];
+    std::uint64_t totalLength;
+    std::uint8_t buffer[64];
+    std::size_t bufferLength;
+
+    void transform(const std::uint8_t block[64]) {
+        std::uint32_t w[64];
+        for (int i = 0; i < 16; ++i) {
+            w[i] = (std::uint32_t(block[4 * i]) << 24) | (std::uint32_t(block[4 * i + 1]) << 16) |
+                   (std::uint32_t(block[4 * i + 2]) << 8) | std::uint32_t(block[4 * i + 3]);
+        }
+        for (int i = 16; i < 64; ++i) {
+            std::uint32_t s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+            std::uint32_t s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+            w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+        }
+        std::uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+        std::uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+        for (int i = 0; i < 64; ++i) {
+            std::uint32_t S1 = rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25);
+            std::uint32_t ch = (e & f) ^ (~e & g);
+            std::uint32_t temp1 = h + S1 + ch + SHA256_K[i] + w[i];
+            std::uint32_t S0 = rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22);
+            std::uint32_t maj = (a & b) ^ (a & c) ^ (b & c);
+            std::uint32_t temp2 = S0 + maj;
+            h = g; g = f; f = e; e = d + temp1;
+            d = c; c = b; b = a; a = temp1 + temp2;
+        }
+        state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+        state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+    }
+};
+
+// HMAC-SHA256 with the key pads computed once and reused for every block
+class HmacSha256 {
+public:
+    HmacSha256(const std::uint8_t* key, std::size_t keyLength) {
+        std::uint8_t keyBlock[64] = {0};
+        if (keyLength > 64) {
+            Sha256 keyHash;
+            keyHash.update(key, keyLength);
+            keyHash.finish(keyBlock);
+        } else if (keyLength > 0) {
+            std::memcpy(keyBlock, key, keyLength);
+        }
+        std::uint8_t pad[64];
+        for (int i = 0; i < 64; ++i) pad[i] = keyBlock[i] ^ 0x36;
+        inner.update(pad, 64);
+        for (int i = 0; i < 64; ++i) pad[i] = keyBlock[i] ^ 0x5c;
+        outer.update(pad, 64);
+    }
+
+    void compute(const std::uint8_t* a, std::size_t aLength, const std::uint8_t* b, std::size_t bLength, std::uint8_t out[32]) const {
+        Sha256 in = inner;
+        in.update(a, aLength);
+        if (bLength > 0) in.update(b, bLength);
+        std::uint8_t innerDigest[32];
+        in.finish(innerDigest);
+        Sha256 out_ = outer;
+        out_.update(innerDigest, 32);
+        out_.finish(out);
+    }
+
+private:
+    Sha256 inner;
+    Sha256 outer;
+};
+
+void salsa20_8(std::uint32_t b[16]) {
+    std::uint32_t x[16];
+    std::memcpy(x, b, sizeof(x));
+    for (int i = 0; i < 8; i += 2) {
+        x[4] ^= rotl(x[0] + x[12], 7);   x[8] ^= rotl(x[4] + x[0], 9);
+        x[12] ^= rotl(x[8] + x[4], 13);  x[0] ^= rotl(x[12] + x[8], 18);
+        x[9] ^= rotl(x[5] + x[1], 7);    x[13] ^= rotl(x[9] + x[5], 9);
+        x[1] ^= rotl(x[13] + x[9], 13);  x[5] ^= rotl(x[1] + x[13], 18);
+        x[14] ^= rotl(x[10] + x[6], 7);  x[2] ^= rotl(x[14] + x[10], 9);
+        x[6] ^= rotl(x[2] + x[14], 13);  x[10] ^= rotl(x[6] + x[2], 18);
+        x[3] ^= rotl(x[15] + x[11], 7);  x[7] ^= rotl(x[3] + x[15], 9);
+        x[11] ^= rotl(x[7] + x[3], 13);  x[15] ^= rotl(x[11] + x[7], 18);
+        x[1] ^= rotl(x[0] + x[3], 7);    x[2] ^= rotl(x[1] + x[0], 9);
+        x[3] ^= rotl(x[2] + x[1], 13);   x[0] ^= rotl(x[3] + x[2], 18);
+        x[6] ^= rotl(x[5] + x[4], 7);    x[7] ^= rotl(x[6] + x[5], 9);
+        x[4] ^= rotl(x[7] + x[6], 13);   x[5] ^= rotl(x[4] + x[7], 18);
+        x[11] ^= rotl(x[10] + x[9], 7);  x[8] ^= rotl(x[11] + x[10], 9);
+        x[9] ^= rotl(x[8] + x[11], 13);  x[10] ^= rotl(x[9] + x[8], 18);
+        x[12] ^= rotl(x[15] + x[14], 7); x[13] ^= rotl(x[12] + x[15], 9);
+        x[14] ^= rotl(x[13] + x[12], 13); x[15] ^= rotl(x[14] + x[13], 18);
+    }
+    for (int i = 0; i < 16; ++i) b[i] += x[i];
+}
+
+// in and out are 2r blocks of 16 words each; out must not alias in
+void blockMix(const std::uint32_t* in, std::uint32_t* out, std::uint32_t r) {
+    std::uint32_t x[16];
+    std::memcpy(x, in + (2 * r - 1) * 16, sizeof(x));
+    for (std::uint32_t i = 0; i < 2 * r; ++i) {
+        for (int k = 0; k < 16; ++k) x[k] ^= in[i * 16 + k];
+        salsa20_8(x);
+        // Even blocks go to the first half of the output, odd ones to the second
+        std::uint32_t target = (i % 2 == 0) ? (i / 2) : (r + i / 2);
+        std::memcpy(out + target * 16, x, sizeof(x));
+    }
+}
+
+void roMix(std::uint8_t* block, std::uint32_t r, std::uint64_t n, std::vector<std::uint32_t>& v) {
+    const std::size_t words = 32 * r;
+    std::vector<std::uint32_t> x(words), y(words);
+    for (std::size_t i = 0; i < words; ++i) {
+        x[i] = std::uint32_t(block[4 * i]) | (std::uint32_t(block[4 * i + 1]) << 8) |
+               (std::uint32_t(block[4 * i + 2]) << 16) | (std::uint32_t(block[4 * i + 3]) << 24);
+    }
+    v.resize(words * n);
+    for (std::uint64_t i = 0; i < n; ++i) {
+        std::memcpy(&v[i * words], x.data(), words * 4);
+        blockMix(x.data(), y.data(), r);
+        x.swap(y);
+    }
+    for (std::uint64_t i = 0; i < n; ++i) {
+        const std::uint32_t* last = &x[(2 * r - 1) * 16];
+        std::uint64_t j = ((std::uint64_t(last[1]) << 32) | last[0]) & (n - 1);
+        const std::uint32_t* vj = &v[j * words];
+        for (std::size_t k = 0; k < words; ++k) x[k] ^= vj[k];
+        blockMix(x.data(), y.data(), r);
+        x.swap(y);
+    }
+    for (std::size_t i = 0; i < words; ++i) {
+        block[4 * i] = static_cast<std::uint8_t>(x[i]);
+        block[4 * i + 1] = static_cast<std::uint8_t>(x[i] >> 8);
+        block[4 * i + 2] = static_cast<std::uint8_t>(x[i] >> 16);
+        block[4 * i + 3] = static_cast<std::uint8_t>(x[i] >> 24);
+    }
+}
+
+std::string toHex(const std::uint8_t* data, std::size_t length) {
+    static const char digits[] = "0123456789abcdef";
+    std::string hex;
+    hex.reserve(length * 2);
+    for (std::size_t i = 0; i < length; ++i) {
+        hex += digits[data[i] >> 4];
+        hex += digits[data[i] & 0x0f];
+    }
+    return hex;
+}
+
+bool fromHex(const std::string& hex, std::vector<std::uint8_t>& out) {
+    if (hex.size() % 2 != 0) return false;
+    out.clear();
+    out.reserve(hex.size() / 2);
+    for (std::size_t i = 0; i < hex.size(); i += 2) {
+        int value = 0;
+        for (int k = 0; k < 2; ++k) {
+            char c = hex[i + k];
+            value <<= 4;
+            if (c >= '0' && c <= '9') value |= c - '0';
+            else if (c >= 'a' && c <= 'f') value |= c - 'a' + 10;
+            else return false;
+        }
+        out.push_back(static_cast<std::uint8_t>(value));
+    }
+    return true;
+}
+
+bool parseRecord(const std::string& record, int& cost, std::vector<std::uint8_t>& salt, std::vector<std::uint8_t>& hash) {
+    if (record.compare(0, 7, "scrypt$") != 0) return false;
+    std::size_t costEnd = record.find('$', 7);
+    if (costEnd == std::string::npos) return false;
+    std::size_t saltEnd = record.find('$', costEnd + 1);
+    if (saltEnd == std::string::npos) return false;
+    try {
+        cost = std::stoi(record.substr(7, costEnd - 7));
+    } catch (...) {
+        return false;
+    }
+    if (cost < 1 || cost > PasswordHasher::MAX_COST) return false;
+    return fromHex(record.substr(costEnd + 1, saltEnd - costEnd - 1), salt) &&
+           fromHex(record.substr(saltEnd + 1), hash) && !hash.empty();
+}
+
+// Compares every byte so the timing does not reveal the matching prefix length
+bool constantTimeEquals(const std::vector<std::uint8_t>& a, const std::vector<std::uint8_t>& b) {
+    if (a.size() != b.size()) return false;
+    std::uint8_t diff = 0;
+    for (std::size_t i = 0; i < a.size(); ++i) diff |= a[i] ^ b[i];
+    return diff == 0;
+}
+
+const std::uint32_t SCRYPT_R = 8;
+const std::uint32_t SCRYPT_P = 1;
+const std::size_t SALT_LENGTH = 16;
+const std::size_t HASH_LENGTH = 32;
+
+} // namespace
+
+std::vector<std::uint8_t> PasswordHasher::sha256(const std::uint8_t* data, std::size_t length) {
+    Sha256 hasher;
+    hasher.update(data, length);
+    std::vector<std::uint8_t> digest(32);
+    hasher.finish(digest.data());
+    return digest;
+}
+
+std::vector<std::uint8_t> PasswordHasher::pbkdf2Sha256(const std::string& password, const std::uint8_t* salt, std::size_t saltLength,
+                                                       std::uint32_t iterations, std::size_t outputLength) {
+    HmacSha256 hmac(reinterpret_cast<const std::uint8_t*>(password.data()), password.size());
+    std::vector<std::uint8_t> output(outputLength);
+    std::vector<std::uint8_t> saltBlock(salt, salt + saltLength);
+    saltBlock.resize(saltLength + 4);
+    for (std::uint32_t blockIndex = 1; (blockIndex - 1) * 32 < outputLength; ++blockIndex) {
+        saltBlock[saltLength] = static_cast<std::uint8_t>(blockIndex >> 24);
+        saltBlock[saltLength + 1] = static_cast<std::uint8_t>(blockIndex >> 16);
+        saltBlock[saltLength + 2] = static_cast<std::uint8_t>(blockIndex >> 8);
+        saltBlock[saltLength + 3] = static_cast<std::uint8_t>(blockIndex);
+        std::uint8_t u[32];
+        std::uint8_t t[32];
+        hmac.compute(saltBlock.data(), saltBlock.size(), nullptr, 0, u);
+        std::memcpy(t, u, 32);
+        for (std::uint32_t i = 1; i < iterations; ++i) {
+            hmac.compute(u, 32, nullptr, 0, u);
+            for (int k = 0; k < 32; ++k) t[k] ^= u[k];
+        }
+        std::size_t offset = (blockIndex - 1) * 32;
+        std::memcpy(output.data() + offset, t, std::min<std::size_t>(32, outputLength - offset));
+    }
+    return output;
+}
+
+std::vector<std::uint8_t> PasswordHasher::scrypt(const std::string& password, const std::uint8_t* salt, std::size_t saltLength,
+                                                 std::uint64_t n, std::uint32_t r, std::uint32_t p, std::size_t outputLength) {
+    std::vector<std::uint8_t> b = pbkdf2Sha256(password, salt, saltLength, 1, static_cast<std::size_t>(p) * 128 * r);
+    std::vector<std::uint32_t> v; // The N * 128 * r byte scratch space that makes this memory-hard
+    for (std::uint32_t i = 0; i < p; ++i) {
+        roMix(b.data() + static_cast<std::size_t>(i) * 128 * r, r, n, v);
+    }
+    return pbkdf2Sha256(password, b.data(), b.size(), 1, outputLength);
+}
+
+std::string PasswordHasher::hash(const std::string& password, int cost) {
+    if (cost < MIN_COST) cost = MIN_COST;
+    if (cost > MAX_COST) cost = MAX_COST;
+    std::uint8_t salt[SALT_LENGTH];
+    OsCrypto::fillRandom(salt, SALT_LENGTH); // Throws rather than hash with a predictable salt
+    std::vector<std::uint8_t> derived = scrypt(password, salt, SALT_LENGTH, std::uint64_t(1) << cost, SCRYPT_R, SCRYPT_P, HASH_LENGTH);
+    return "scrypt$" + std::to_string(cost) + "$" + toHex(salt, SALT_LENGTH) + "$" + toHex(derived.data(), derived.size());
+}
+
+bool PasswordHasher::verify(const std::string& password, const std::string& record) {
+    if (isLegacy(record)) {
+        return std::to_string(std::hash<std::string>{}(password)) == record;
+    }
+    int cost;
+    std::vector<std::uint8_t> salt, expected;
+    if (!parseRecord(record, cost, salt, expected)) return false;
+    std::vector<std::uint8_t> derived = scrypt(password, salt.data(), salt.size(), std::uint64_t(1) << cost, SCRYPT_R, SCRYPT_P, expected.size());
+    return constantTimeEquals(derived, expected);
+}
+
+int PasswordHasher::getCost(const std::string& record) {
+    int cost;
+    std::vector<std::uint8_t> salt, expected;
+    return parseRecord(record, cost, salt, expected) ? cost : 0;
+}
+
+bool PasswordHasher::isLegacy(const std::string& record) {
+    return !record.empty() && record.find_first_not_of("0123456789") == std::string::npos;
+}
+
+bool PasswordHasher::needsRehash(const std::string& record, int cost) {
+    return isLegacy(record) || getCost(record) < cost;
+}
@@ -0,0 +1,678 @@
+#include "replication.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+
+#ifdef _WIN32
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+#ifdef _WIN32
+typedef SOCKET SocketHandle;
+const SocketHandle NO_SOCKET = INVALID_SOCKET;
+void closeSocket(SocketHandle socket) { closesocket(socket); }
+#else
+typedef int SocketHandle;
+const SocketHandle NO_SOCKET = -1;
+void closeSocket(SocketHandle socket) { close(socket); }
+#endif
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+enum FrameType : std::uint8_t {
+    FRAME_HELLO = 1,
+    FRAME_BATCH = 2,
+    FRAME_ACK = 3
+};
+
+// Anything bigger is a corrupt or foreign stream
+const std::uint32_t MAX_FRAME_SIZE = 16 * 1024 * 1024;
+const auto RECONNECT_DELAY = std::chrono::seconds(1);
+const int SELECT_TIMEOUT_MS = 20;
+
+enum DeltaFlags : std::uint8_t {
+    DELTA_DELETED = 1,
+    DELTA_AVAILABLE = 2,
+    DELTA_FROM_SENDER = 4 // Stamp origin is the sending instance, so it is left out
+};
+
+struct Connection {
+    SocketHandle socket = NO_SOCKET;
+    std::string input;        // Received bytes not yet split into frames
+    bool ready = false;       // Outbound: the peer answered HELLO
+    std::uint64_t sender = 0; // Inbound: origin from the peer's HELLO
+};
+
+void putVarint(std::string& out, std::uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+bool getVarint(const std::string& in, std::size_t& pos, std::uint64_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 64 && pos < in.size(); shift += 7) {
+        std::uint8_t byte = static_cast<std::uint8_t>(in[pos++]);
+        value |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void putString(std::string& out, const std::string& value) {
+    putVarint(out, value.size());
+    out += value;
+}
+
+bool getString(const std::string& in, std::size_t& pos, std::string& value) {
+    std::uint64_t size;
+    if (!getVarint(in, pos, size) || size > in.size() - pos) {
+        return false;
+    }
+    value.assign(in, pos, size);
+    pos += size;
+    return true;
+}
+
+std::string frame(std::uint8_t type, const std::string& body) {
+    std::uint32_t size = static_cast<std::uint32_t>(body.size() + 1);
+    std::string out;
+    out.reserve(body.size() + 5);
+    for (int i = 0; i < 4; ++i) {
+        out.push_back(static_cast<char>((size >> (8 * i)) & 0xff));
+    }
+    out.push_back(static_cast<char>(type));
+    out += body;
+    return out;
+}
+
+// 1 = a frame was taken off the front of input, 0 = need more bytes, -1 = bad stream
+int nextFrame(std::string& input, std::uint8_t& type, std::string& body) {
+    if (input.size() < 4) {
+        return 0;
+    }
+    std::uint32_t size = 0;
+    for (int i = 0; i < 4; ++i) {
+        size |= static_cast<std::uint32_t>(static_cast<std::uint8_t>(input[i])) << (8 * i);
+    }
+    if (size == 0 || size > MAX_FRAME_SIZE) {
+        return -1;
+    }
+    if (input.size() < 4 + static_cast<std::size_t>(size)) {
+        return 0;
+    }
+    type = static_cast<std::uint8_t>(input[4]);
+    body.assign(input, 5, size - 1);
+    input.erase(0, 4 + static_cast<std::size_t>(size));
+    return 1;
+}
+
+void setNoDelay(SocketHandle socket) {
+    int yes = 1;
+    setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&yes), sizeof(yes));
+}
+
+SocketHandle openListener(const std::string& host, unsigned short port) {
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    if (inet_pton(AF_INET, host.c_str(), &address.sin_addr) != 1) {
+        return NO_SOCKET;
+    }
+    SocketHandle listener = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (listener == NO_SOCKET) {
+        return NO_SOCKET;
+    }
+    int yes = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&yes), sizeof(yes));
+    if (bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(listener, 4) != 0) {
+        closeSocket(listener);
+        return NO_SOCKET;
+    }
+    return listener;
+}
+
+SocketHandle connectTo(const std::string& host, unsigned short port) {
+    addrinfo hints{};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* addresses = nullptr;
+    if (getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &addresses) != 0) {
+        return NO_SOCKET;
+    }
+    SocketHandle connection = NO_SOCKET;
+    for (addrinfo* address = addresses; address && connection == NO_SOCKET; address = address->ai_next) {
+        connection = socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+        if (connection != NO_SOCKET && connect(connection, address->ai_addr, static_cast<int>(address->ai_addrlen)) != 0) {
+            closeSocket(connection);
+            connection = NO_SOCKET;
+        }
+    }
+    freeaddrinfo(addresses);
+    if (connection != NO_SOCKET) {
+        setNoDelay(connection);
+    }
+    return connection;
+}
+
+bool sendAll(SocketHandle socket, const std::string& data) {
+    std::size_t sent = 0;
+    while (sent < data.size()) {
+        int n = send(socket, data.data() + sent, static_cast<int>(data.size() - sent), MSG_NOSIGNAL);
+        if (n <= 0) {
+            return false;
+        }
+        sent += static_cast<std::size_t>(n);
+    }
+    return true;
+}
+
+// False once the peer closed the connection or it failed
+bool receiveInto(Connection& connection, std::atomic<std::uint64_t>& counter) {
+    char buffer[16384];
+    int n = recv(connection.socket, buffer, sizeof(buffer), 0);
+    if (n <= 0) {
+        return false;
+    }
+    connection.input.append(buffer, static_cast<std::size_t>(n));
+    counter += static_cast<std::uint64_t>(n);
+    return true;
+}
+
+// Capacity is zigzag-encoded so a negative value stays short
+void encodeDelta(std::string& out, const std::string& room, bool deleted, int capacity, bool available, const std::string& bookedBy,
+                 const std::string& modifiedBy, std::uint64_t clock, std::uint64_t origin, std::uint64_t sender) {
+    std::uint8_t flags = (deleted ? DELTA_DELETED : 0) | (available ? DELTA_AVAILABLE : 0) | (origin == sender ? DELTA_FROM_SENDER : 0);
+    out.push_back(static_cast<char>(flags));
+    putVarint(out, clock);
+    if (origin != sender) {
+        putVarint(out, origin);
+    }
+    putString(out, room);
+    putString(out, modifiedBy);
+    if (!deleted) {
+        std::int64_t value = capacity;
+        putVarint(out, (static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63));
+        putString(out, bookedBy);
+    }
+}
+
+bool parseHostPort(const std::string& setting, std::string& host, unsigned short& port) {
+    std::size_t colon = setting.rfind(':');
+    std::string portText = colon == std::string::npos ? setting : setting.substr(colon + 1);
+    if (colon != std::string::npos) {
+        host = setting.substr(0, colon);
+    }
+    int value = std::atoi(portText.c_str());
+    if (value <= 0 || value > 65535) {
+        return false;
+    }
+    port = static_cast<unsigned short>(value);
+    return true;
+}
+
+} // namespace
+
+Replicator::Replicator(RoomManager& rm)
+    : rm(rm), peerPort(0), clock(0), nextSeq(1), peerOrigin(0), running(false), paused(false), applying(false),
+      listening(false), peerConnected(false), inboundPeers(0), deltasSent(0), deltasApplied(0), bytesSent(0), bytesReceived(0) {
+    std::random_device device;
+    origin = (static_cast<std::uint64_t>(device()) << 32) ^ device() ^
+             static_cast<std::uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+    if (origin == 0) {
+        origin = 1;
+    }
+}
+
+Replicator::~Replicator() {
+    if (running) {
+        rm.setChangeObserver(nullptr);
+        running = false;
+        worker.join();
+#ifdef _WIN32
+        WSACleanup();
+#endif
+    }
+}
+
+bool Replicator::start(const std::string& listenHost, unsigned short listenPort, const std::string& peerHost, unsigned short peerPort) {
+    if (running || (listenPort == 0 && peerHost.empty())) {
+        return false;
+    }
+#ifdef _WIN32
+    WSADATA data;
+    if (WSAStartup(MAKEWORD(2, 2), &data) != 0) {
+        return false;
+    }
+#endif
+    SocketHandle listener = NO_SOCKET;
+    if (listenPort != 0) {
+        listener = openListener(listenHost, listenPort);
+        if (listener == NO_SOCKET) {
+            std::cerr << "Replication: cannot listen on " << listenHost << ":" << listenPort << std::endl;
+#ifdef _WIN32
+            WSACleanup();
+#endif
+            return false;
+        }
+        listening = true;
+    }
+    this->peerHost = peerHost;
+    this->peerPort = peerPort;
+
+    // Rooms that exist now carry clock 0, so any change made after startup wins over them
+    for (const auto& room : rm.getRooms()) {
+        Delta delta;
+        delta.room = room.getName();
+        delta.capacity = room.getCapacity();
+        delta.available = room.isAvailable();
+        delta.bookedBy = room.getBookedBy();
+        delta.modifiedBy = room.getLastModifiedBy();
+        delta.stamp = Stamp{0, origin};
+        latest[delta.room] = delta;
+        latestOrder.push_back(delta.room);
+    }
+    rm.setChangeObserver([this](const std::string& roomName, const Room* room) { capture(roomName, room); });
+    running = true;
+    worker = std::thread(&Replicator::networkLoop, this, static_cast<std::intptr_t>(listener));
+    return true;
+}
+
+bool Replicator::configureFromEnvironment() {
+    const char* listenValue = std::getenv("IFM_REPLICA_LISTEN");
+    const char* peerValue = std::getenv("IFM_REPLICA_PEER");
+    std::string listenHost = "127.0.0.1";
+    unsigned short listenPort = 0;
+    std::string peer;
+    unsigned short peerPort = 0;
+    if (listenValue && *listenValue && !parseHostPort(listenValue, listenHost, listenPort)) {
+        std::cerr << "Replication: ignoring IFM_REPLICA_LISTEN=" << listenValue << std::endl;
+    }
+    if (peerValue && *peerValue && (!parseHostPort(peerValue, peer, peerPort) || peer.empty())) {
+        std::cerr << "Replication: ignoring IFM_REPLICA_PEER=" << peerValue << std::endl;
+        peer.clear();
+    }
+    return start(listenHost, listenPort, peer, peerPort);
+}
+
+bool Replicator::isRunning() const {
+    return running;
+}
+
+void Replicator::setPaused(bool paused) {
+    this->paused = paused;
+}
+
+void Replicator::capture(const std::string& roomName, const Room* room) {
+    if (applying) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    Delta delta;
+    delta.room = roomName;
+    delta.deleted = room == nullptr;
+    if (room) {
+        delta.capacity = room->getCapacity();
+        delta.available = room->isAvailable();
+        delta.bookedBy = room->getBookedBy();
+        delta.modifiedBy = room->getLastModifiedBy();
+    }
+    delta.stamp = Stamp{++clock, origin};
+    auto it = latest.find(roomName);
+    if (it == latest.end()) {
+        latestOrder.push_back(roomName);
+    }
+    latest[roomName] = delta;
+    if (!peerHost.empty()) {
+        queuePending(delta);
+    }
+}
+
+// Caller holds the mutex
+void Replicator::queuePending(const Delta& delta) {
+    auto it = pending.find(delta.room);
+    if (it == pending.end()) {
+        pendingOrder.push_back(delta.room);
+        pending.emplace(delta.room, delta);
+    } else if (it->second.stamp < delta.stamp) {
+        it->second = delta;
+    }
+}
+
+// Unacked deltas go back into the queue; the peer ignores any it already applied
+void Replicator::requeueInflight() {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (const auto& entry : inflight) {
+        queuePending(entry.second);
+    }
+    inflight.clear();
+}
+
+void Replicator::poll() {
+    std::vector<Delta> received;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        received.swap(inbox);
+    }
+    if (received.empty()) {
+        return;
+    }
+    rm.beginBatch();
+    applying = true;
+    for (const auto& delta : received) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            clock = std::max(clock, delta.stamp.clock);
+            auto it = latest.find(delta.room);
+            if (it != latest.end() && !(it->second.stamp < delta.stamp)) {
+                continue;
+            }
+            bool unchanged = it != latest.end() && it->second.deleted == delta.deleted && it->second.capacity == delta.capacity &&
+                             it->second.available == delta.available && it->second.bookedBy == delta.bookedBy &&
+                             it->second.modifiedBy == delta.modifiedBy;
+            if (it == latest.end()) {
+                latestOrder.push_back(delta.room);
+            }
+            latest[delta.room] = delta;
+            if (unchanged) {
+                continue;
+            }
+        }
+        if (delta.deleted) {
+            if (rm.findRoom(delta.room)) {
+                rm.deleteRoom(delta.room, delta.modifiedBy);
+            }
+        } else {
+            Room state(delta.room, delta.modifiedBy, delta.capacity, delta.available);
+            state.setBookedBy(delta.bookedBy);
+            rm.putRoom(state);
+        }
+        deltasApplied++;
+    }
+    applying = false;
+    rm.endBatch();
+}
+
+Replicator::Stats Replicator::getStats() const {
+    Stats stats;
+    stats.listening = listening;
+    stats.peerConnected = peerConnected;
+    stats.inboundPeers = inboundPeers;
+    stats.deltasSent = deltasSent;
+    stats.deltasApplied = deltasApplied;
+    stats.bytesSent = bytesSent;
+    stats.bytesReceived = bytesReceived;
+    std::lock_guard<std::mutex> lock(mutex);
+    stats.pendingDeltas = pending.size() + inflight.size();
+    return stats;
+}
+
+std::string Replicator::encodeHello() {
+    std::string body;
+    putVarint(body, origin);
+    std::lock_guard<std::mutex> lock(mutex);
+    putVarint(body, clock);
+    return frame(FRAME_HELLO, body);
+}
+
+// Up to MAX_BATCH_DELTAS queued deltas as one BATCH frame; empty when nothing is queued
+std::string Replicator::takeBatch() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (pendingOrder.empty()) {
+        return "";
+    }
+    std::size_t count = std::min(pendingOrder.size(), MAX_BATCH_DELTAS);
+    std::string body;
+    putVarint(body, nextSeq);
+    putVarint(body, count);
+    for (std::size_t i = 0; i < count; ++i) {
+        auto it = pending.find(pendingOrder[i]);
+        const Delta& delta = it->second;
+        encodeDelta(body, delta.room, delta.deleted, delta.capacity, delta.available, delta.bookedBy, delta.modifiedBy,
+                    delta.stamp.clock, delta.stamp.origin, origin);
+        inflight.emplace_back(nextSeq++, delta);
+        pending.erase(it);
+    }
+    pendingOrder.erase(pendingOrder.begin(), pendingOrder.begin() + count);
+    deltasSent += count;
+    return frame(FRAME_BATCH, body);
+}
+
+bool Replicator::handleOutbound(std::uint8_t type, const std::string& body) {
+    std::size_t pos = 0;
+    if (type == FRAME_HELLO) {
+        std::uint64_t peer, peerClock;
+        if (!getVarint(body, pos, peer) || !getVarint(body, pos, peerClock)) {
+            return false;
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        clock = std::max(clock, peerClock);
+        if (peer != peerOrigin) {
+            // New or restarted peer: it may have none of our state, so send all of it
+            pending.clear();
+            pendingOrder.clear();
+            inflight.clear();
+            for (const auto& name : latestOrder) {
+                queuePending(latest[name]);
+            }
+            peerOrigin = peer;
+        }
+        return true;
+    }
+    if (type == FRAME_ACK) {
+        std::uint64_t acked;
+        if (!getVarint(body, pos, acked)) {
+            return false;
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        while (!inflight.empty() && inflight.front().first <= acked) {
+            inflight.pop_front();
+        }
+        return true;
+    }
+    return false;
+}
+
+bool Replicator::handleInbound(std::uint8_t type, const std::string& body, std::uint64_t& sender, std::string& reply) {
+    std::size_t pos = 0;
+    if (type == FRAME_HELLO) {
+        std::uint64_t peerClock;
+        if (!getVarint(body, pos, sender) || !getVarint(body, pos, peerClock) || sender == 0) {
+            return false;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            clock = std::max(clock, peerClock);
+        }
+        reply = encodeHello();
+        return true;
+    }
+    if (type != FRAME_BATCH || sender == 0) {
+        return false;
+    }
+    std::uint64_t firstSeq, count;
+    if (!getVarint(body, pos, firstSeq) || !getVarint(body, pos, count)) {
+        return false;
+    }
+    std::vector<Delta> deltas;
+    for (std::uint64_t i = 0; i < count; ++i) {
+        if (pos >= body.size()) {
+            return false;
+        }
+        Delta delta;
+        std::uint8_t flags = static_cast<std::uint8_t>(body[pos++]);
+        delta.deleted = flags & DELTA_DELETED;
+        delta.available = flags & DELTA_AVAILABLE;
+        delta.stamp.origin = sender;
+        if (!getVarint(body, pos, delta.stamp.clock) || (!(flags & DELTA_FROM_SENDER) && !getVarint(body, pos, delta.stamp.origin)) ||
+            !getString(body, pos, delta.room) || !getString(body, pos, delta.modifiedBy)) {
+            return false;
+        }
+        if (!delta.deleted) {
+            std::uint64_t capacity;
+            if (!getVarint(body, pos, capacity) || !getString(body, pos, delta.bookedBy)) {
+                return false;
+            }
+            delta.capacity = static_cast<int>(static_cast<std::int64_t>(capacity >> 1) ^ -static_cast<std::int64_t>(capacity & 1));
+        }
+        deltas.push_back(std::move(delta));
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    std::uint64_t& last = receivedSeq[sender];
+    for (std::uint64_t i = 0; i < count; ++i) {
+        if (firstSeq + i > last) {
+            inbox.push_back(std::move(deltas[i]));
+        }
+    }
+    last = std::max(last, firstSeq + count - 1);
+    std::string ack;
+    putVarint(ack, last);
+    reply = frame(FRAME_ACK, ack);
+    return true;
+}
+
+void Replicator::networkLoop(std::intptr_t listenHandle) {
+    SocketHandle listener = static_cast<SocketHandle>(listenHandle);
+    Connection outbound;
+    std::vector<Connection> inbound;
+    auto nextAttempt = std::chrono::steady_clock::now();
+
+    auto closeOutbound = [&]() {
+        closeSocket(outbound.socket);
+        outbound = Connection();
+        peerConnected = false;
+        requeueInflight();
+        nextAttempt = std::chrono::steady_clock::now() + RECONNECT_DELAY;
+    };
+    auto sendOutbound = [&](const std::string& data) {
+        if (!sendAll(outbound.socket, data)) {
+            closeOutbound();
+            return false;
+        }
+        bytesSent += data.size();
+        return true;
+    };
+
+    while (running) {
+        if (paused) {
+            if (outbound.socket != NO_SOCKET) {
+                closeOutbound();
+            }
+            for (auto& connection : inbound) {
+                closeSocket(connection.socket);
+            }
+            inbound.clear();
+        } else if (!peerHost.empty() && outbound.socket == NO_SOCKET && std::chrono::steady_clock::now() >= nextAttempt) {
+            outbound.socket = connectTo(peerHost, peerPort);
+            if (outbound.socket == NO_SOCKET || !sendOutbound(encodeHello())) {
+                outbound = Connection();
+                nextAttempt = std::chrono::steady_clock::now() + RECONNECT_DELAY;
+            }
+        }
+        inboundPeers = inbound.size();
+
+        fd_set readable;
+        FD_ZERO(&readable);
+        SocketHandle highest = 0;
+        auto watch = [&](SocketHandle socket) {
+            FD_SET(socket, &readable);
+            highest = std::max(highest, socket);
+        };
+        if (listener != NO_SOCKET && !paused) watch(listener);
+        if (outbound.socket != NO_SOCKET) watch(outbound.socket);
+        for (const auto& connection : inbound) watch(connection.socket);
+        timeval timeout{0, SELECT_TIMEOUT_MS * 1000};
+        int ready = select(static_cast<int>(highest + 1), &readable, nullptr, nullptr, &timeout);
+        if (ready < 0) {
+            // Nothing to wait on (Windows fails an empty select); just pace the loop
+            std::this_thread::sleep_for(std::chrono::milliseconds(SELECT_TIMEOUT_MS));
+            FD_ZERO(&readable);
+        }
+
+        if (listener != NO_SOCKET && !paused && FD_ISSET(listener, &readable)) {
+            Connection connection;
+            connection.socket = accept(listener, nullptr, nullptr);
+            if (connection.socket != NO_SOCKET) {
+                setNoDelay(connection.socket);
+                inbound.push_back(std::move(connection));
+            }
+        }
+
+        if (outbound.socket != NO_SOCKET && FD_ISSET(outbound.socket, &readable)) {
+            bool alive = receiveInto(outbound, bytesReceived);
+            std::uint8_t type;
+            std::string body;
+            int result;
+            while (alive && (result = nextFrame(outbound.input, type, body)) != 0) {
+                alive = result > 0 && handleOutbound(type, body);
+                if (alive && type == FRAME_HELLO) {
+                    outbound.ready = true;
+                    peerConnected = true;
+                }
+            }
+            if (!alive) {
+                closeOutbound();
+            }
+        }
+
+        for (std::size_t i = 0; i < inbound.size();) {
+            Connection& connection = inbound[i];
+            bool alive = true;
+            if (FD_ISSET(connection.socket, &readable)) {
+                alive = receiveInto(connection, bytesReceived);
+                std::uint8_t type;
+                std::string body, reply;
+                int result;
+                while (alive && (result = nextFrame(connection.input, type, body)) != 0) {
+                    alive = result > 0 && handleInbound(type, body, connection.sender, reply) && sendAll(connection.socket, reply);
+                    if (alive) {
+                        bytesSent += reply.size();
+                    }
+                }
+            }
+            if (alive) {
+                ++i;
+            } else {
+                closeSocket(connection.socket);
+                inbound.erase(inbound.begin() + i);
+            }
+        }
+
+        if (outbound.ready) {
+            for (std::string batch = takeBatch(); !batch.empty() && sendOutbound(batch); batch = takeBatch()) {
+            }
+        }
+    }
+
+    if (outbound.socket != NO_SOCKET) {
+        closeSocket(outbound.socket);
+    }
+    for (auto& connection : inbound) {
+        closeSocket(connection.socket);
+    }
+    if (listener != NO_SOCKET) {
+        closeSocket(listener);
+    }
+}
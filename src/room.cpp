@@ -1,6 +1,7 @@
 #include "room.hpp"
 #include "ui.hpp"
 #include "history.hpp"
+#include "durability.hpp"
 #include <iostream>
 #include <fstream>
 #include <sstream>
@@ -8,7 +9,7 @@
 
 // Room class implementation
 Room::Room(const std::string& name, const std::string& lastModifiedBy, int capacity, bool isAvailable)
-    : name(name), lastModifiedBy(lastModifiedBy), capacity(capacity), m_isAvailable(isAvailable) {
+    : name(name), lastModifiedBy(lastModifiedBy), capacity(capacity), m_isAvailable(isAvailable), version(0) {
     timestamp = time(0);
 }
 
@@ -18,21 +19,25 @@ time_t Room::getTimestamp() const { return timestamp; }
 int Room::getCapacity() const { return capacity; }
 bool Room::isAvailable() const { return m_isAvailable; }
 std::string Room::getBookedBy() const { return bookedBy; }
+std::uint64_t Room::getVersion() const { return version; }
 
 void Room::setCapacity(int capacity) { this->capacity = capacity; }
 void Room::setAvailable(bool isAvailable) { this->m_isAvailable = isAvailable; }
 void Room::setLastModifiedBy(const std::string& adminName) { this->lastModifiedBy = adminName; }
 void Room::setTimestamp(time_t timestamp) { this->timestamp = timestamp; }
 void Room::setBookedBy(const std::string& username) { this->bookedBy = username; }
+void Room::setVersion(std::uint64_t version) { this->version = version; }
 
 // RoomManager class implementation
-RoomManager::RoomManager() {
+RoomManager::RoomManager() : tableVersion(0), batchDepth(0), saveDeferred(false) {
     historyManager = new RoomHistoryManager();
     loadRooms();
 }
 
+// The version column is optional; rooms saved before it existed get fresh stamps
 void RoomManager::loadRooms() {
     rooms.clear();
+    std::vector<std::size_t> unversioned;
     std::ifstream file(ROOMS_FILE);
     if (file.is_open()) {
         std::string name, lastModifiedBy, capacity_str, isAvailable_str, bookedBy;
@@ -47,6 +52,13 @@ void RoomManager::loadRooms() {
                     if (bookedBy != "none") {
                         room.setBookedBy(bookedBy);
                     }
+                    std::uint64_t version = 0;
+                    if (ss >> version) {
+                        room.setVersion(version);
+                        tableVersion = std::max(tableVersion.load(), version);
+                    } else {
+                        unversioned.push_back(rooms.size());
+                    }
                     rooms.push_back(room);
                 } catch (const std::invalid_argument& e) {
                     std::cerr << "Skipping malformed line in rooms.txt: " << line << std::endl;
@@ -55,29 +67,78 @@ void RoomManager::loadRooms() {
         }
         file.close();
     }
+    for (std::size_t position : unversioned) {
+        rooms[position].setVersion(++tableVersion);
+    }
+    rebuildIndex();
+}
+
+void RoomManager::rebuildIndex() {
+    roomIndex.clear();
+    roomIndex.reserve(rooms.size());
+    for (std::size_t i = 0; i < rooms.size(); ++i) {
+        roomIndex[rooms[i].getName()] = i;
+    }
+}
+
+void RoomManager::markModified(Room& room) {
+    room.setVersion(++tableVersion);
+    if (changeObserver) {
+        changeObserver(room.getName(), &room);
+    }
+}
+
+void RoomManager::setChangeObserver(ChangeObserver observer) {
+    changeObserver = std::move(observer);
+}
+
+std::uint64_t RoomManager::getVersion() const {
+    return tableVersion;
+}
+
+std::uint64_t RoomManager::getRoomVersion(const std::string& roomName) {
+    Room* room = findRoom(roomName);
+    return room ? room->getVersion() : 0;
 }
 
 std::vector<Room>& RoomManager::getRooms() {
     return rooms;
 }
 
+void RoomManager::beginBatch() {
+    batchDepth++;
+    historyManager->beginBatch();
+}
+
+void RoomManager::endBatch() {
+    if (batchDepth == 0) {
+        return;
+    }
+    historyManager->endBatch();
+    if (--batchDepth == 0 && saveDeferred) {
+        saveDeferred = false;
+        saveRooms();
+    }
+}
+
 void RoomManager::saveRooms() {
-    std::ofstream file(ROOMS_FILE);
-    if (file.is_open()) {
-        for (const auto& room : rooms) {
-            file << room.getName() << " " << room.getLastModifiedBy() << " " << room.getCapacity() << " " << (room.isAvailable() ? "Yes" : "No") << " " << (room.getBookedBy().empty() ? "none" : room.getBookedBy()) << std::endl;
-        }
-        file.close();
+    if (batchDepth > 0) {
+        saveDeferred = true;
+        return;
+    }
+    std::ostringstream out;
+    for (const auto& room : rooms) {
+        out << room.getName() << " " << room.getLastModifiedBy() << " " << room.getCapacity() << " " << (room.isAvailable() ? "Yes" : "No") << " " << (room.getBookedBy().empty() ? "none" : room.getBookedBy()) << " " << room.getVersion() << "\n";
+    }
+    if (!Durability::writeFile(ROOMS_FILE, out.str())) {
+        std::cerr << "Failed to save " << ROOMS_FILE << std::endl;
     }
 }
 
 Room* RoomManager::findRoom(const std::string& roomName) {
-    auto it = std::find_if(rooms.begin(), rooms.end(), [&](const Room& r) {
-        return r.getName() == roomName;
-    });
-
-    if (it != rooms.end()) {
-        return &(*it);
+    auto it = roomIndex.find(roomName);
+    if (it != roomIndex.end()) {
+        return &rooms[it->second];
     }
 
     return nullptr;
@@ -109,6 +170,8 @@ void RoomManager::uploadRoom(const std::string& adminName) {
     isAvailable = (availableInput == 1);
 
     rooms.emplace_back(roomName, adminName, capacity, isAvailable);
+    roomIndex[roomName] = rooms.size() - 1;
+    markModified(rooms.back());
     historyManager->logCreate(roomName, adminName, capacity, isAvailable);
     saveRooms();
     UI::displayMessage("Room '" + roomName + "' has been uploaded successfully.");
@@ -121,6 +184,11 @@ void RoomManager::deleteRoom(const std::string& roomName, const std::string& adm
 
     if (it != rooms.end()) {
         rooms.erase(it, rooms.end());
+        rebuildIndex();
+        tableVersion++;
+        if (changeObserver) {
+            changeObserver(roomName, nullptr);
+        }
         historyManager->logDelete(roomName, adminName);
         saveRooms();
         UI::displayMessage("Room '" + roomName + "' has been deleted successfully.");
@@ -151,6 +219,7 @@ void RoomManager::modifyRoom(const std::string& adminName) {
         it->setAvailable(isAvailable);
         it->setLastModifiedBy(adminName);
         it->setTimestamp(time(0));
+        markModified(*it);
         historyManager->logModify(roomName, adminName, capacity, isAvailable);
 
         saveRooms();
@@ -161,31 +230,47 @@ void RoomManager::modifyRoom(const std::string& adminName) {
 }
 
 void RoomManager::addRoom(const std::string& adminName, const std::string& roomName, int capacity, bool isAvailable) {
-    auto it = std::find_if(rooms.begin(), rooms.end(), [&](const Room& r) {
-        return r.getName() == roomName;
-    });
-
-    if (it != rooms.end()) {
+    if (findRoom(roomName)) {
         // In GUI mode, we might want to handle this message differently, but for now, it's fine.
         // UI::displayMessage("Error: Room '" + roomName + "' already exists.");
         return;
     }
 
     rooms.emplace_back(roomName, adminName, capacity, isAvailable);
+    roomIndex[roomName] = rooms.size() - 1;
+    markModified(rooms.back());
     historyManager->logCreate(roomName, adminName, capacity, isAvailable);
     saveRooms();
 }
 
+void RoomManager::putRoom(const Room& state) {
+    Room* room = findRoom(state.getName());
+    if (room) {
+        room->setCapacity(state.getCapacity());
+        room->setAvailable(state.isAvailable());
+        room->setBookedBy(state.getBookedBy());
+        room->setLastModifiedBy(state.getLastModifiedBy());
+        room->setTimestamp(time(0));
+        markModified(*room);
+        historyManager->logModify(state.getName(), state.getLastModifiedBy(), state.getCapacity(), state.isAvailable());
+    } else {
+        rooms.push_back(state);
+        roomIndex[state.getName()] = rooms.size() - 1;
+        markModified(rooms.back());
+        historyManager->logCreate(state.getName(), state.getLastModifiedBy(), state.getCapacity(), state.isAvailable());
+    }
+    saveRooms();
+}
+
 void RoomManager::modifyRoom(const std::string& adminName, const std::string& roomName, int capacity, bool isAvailable) {
-    auto it = std::find_if(rooms.begin(), rooms.end(), [&](const Room& r) {
-        return r.getName() == roomName;
-    });
+    Room* it = findRoom(roomName);
 
-    if (it != rooms.end()) {
+    if (it) {
         it->setCapacity(capacity);
         it->setAvailable(isAvailable);
         it->setLastModifiedBy(adminName);
         it->setTimestamp(time(0));
+        markModified(*it);
         historyManager->logModify(roomName, adminName, capacity, isAvailable);
 
         saveRooms();
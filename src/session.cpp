@@ -0,0 +1,107 @@
+#include "session.hpp"
+#include "oscrypto.hpp"
+#include <cstdint>
+#include <functional>
+
+SessionStore::SessionStore(std::chrono::seconds ttl) : timeToLive(ttl) {}
+
+void SessionStore::setTimeToLive(std::chrono::seconds ttl) {
+    timeToLive = ttl;
+}
+
+SessionStore::Shard& SessionStore::shardFor(const std::string& token) {
+    return shards[std::hash<std::string>{}(token) % SHARD_COUNT];
+}
+
+std::string SessionStore::generateToken() {
+    // 128 bits from the OS CSPRNG, hex encoded; tokens are bearer credentials
+    std::uint8_t bytes[16];
+    OsCrypto::fillRandom(bytes, sizeof(bytes));
+    static const char digits[] = "0123456789abcdef";
+    std::string token;
+    token.reserve(32);
+    for (std::uint8_t byte : bytes) {
+        token += digits[byte >> 4];
+        token += digits[byte & 0x0f];
+    }
+    return token;
+}
+
+// Lock order is always userIndexMutex before a shard lock, so issue() and the
+// revocations cannot leave a token behind that is missing from the user index.
+std::string SessionStore::issue(const std::string& username, int role) {
+    std::string token = generateToken();
+    Session session{username, role, std::chrono::steady_clock::now() + timeToLive};
+    std::lock_guard<std::mutex> indexLock(userIndexMutex);
+    {
+        Shard& shard = shardFor(token);
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        shard.sessions[token] = session;
+    }
+    tokensByUser[username].insert(token);
+    return token;
+}
+
+bool SessionStore::validate(const std::string& token, Session& session) {
+    Shard& shard = shardFor(token);
+    {
+        std::shared_lock<std::shared_mutex> lock(shard.mutex);
+        auto it = shard.sessions.find(token);
+        if (it == shard.sessions.end()) {
+            return false;
+        }
+        if (std::chrono::steady_clock::now() < it->second.expiresAt) {
+            session = it->second;
+            return true;
+        }
+    }
+    revoke(token); // Expired
+    return false;
+}
+
+void SessionStore::revoke(const std::string& token) {
+    std::lock_guard<std::mutex> indexLock(userIndexMutex);
+    std::string username;
+    {
+        Shard& shard = shardFor(token);
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        auto it = shard.sessions.find(token);
+        if (it == shard.sessions.end()) {
+            return;
+        }
+        username = it->second.username;
+        shard.sessions.erase(it);
+    }
+    auto userIt = tokensByUser.find(username);
+    if (userIt != tokensByUser.end()) {
+        userIt->second.erase(token);
+        if (userIt->second.empty()) tokensByUser.erase(userIt);
+    }
+}
+
+void SessionStore::revokeUser(const std::string& username) {
+    std::lock_guard<std::mutex> indexLock(userIndexMutex);
+    auto it = tokensByUser.find(username);
+    if (it == tokensByUser.end()) {
+        return;
+    }
+    for (const auto& token : it->second) {
+        Shard& shard = shardFor(token);
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        shard.sessions.erase(token);
+    }
+    tokensByUser.erase(it);
+}
+
+std::size_t SessionStore::purgeExpired() {
+    auto now = std::chrono::steady_clock::now();
+    std::vector<std::string> expired;
+    for (auto& shard : shards) {
+        std::shared_lock<std::shared_mutex> lock(shard.mutex);
+        for (const auto& entry : shard.sessions) {
+            if (entry.second.expiresAt <= now) expired.push_back(entry.first);
+        }
+    }
+    for (const auto& token : expired) revoke(token);
+    return expired.size();
+}
@@ -0,0 +1,46 @@
+#include "threadpool.hpp"
+
+ThreadPool::ThreadPool(std::size_t threadCount) : stopping(false) {
+    if (threadCount == 0) {
+        threadCount = defaultThreadCount();
+    }
+    for (std::size_t i = 0; i < threadCount; ++i) {
+        workers.emplace_back(&ThreadPool::workerLoop, this);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        stopping = true;
+    }
+    taskAvailable.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+std::size_t ThreadPool::size() const {
+    return workers.size();
+}
+
+std::size_t ThreadPool::defaultThreadCount() {
+    unsigned int hw = std::thread::hardware_concurrency();
+    return hw == 0 ? 2 : hw;
+}
+
+void ThreadPool::workerLoop() {
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(queueMutex);
+            taskAvailable.wait(lock, [this]() { return stopping || !tasks.empty(); });
+            if (stopping && tasks.empty()) {
+                return; // Drain remaining work before shutting down
+            }
+            task = std::move(tasks.front());
+            tasks.pop();
+        }
+        task();
+    }
+}
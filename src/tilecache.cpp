@@ -0,0 +1,117 @@
+#include "tilecache.hpp"
+#include "rlgl.h"
+
+TileCache::TileCache(int tileWidth, int tileHeight, int atlasWidth, int atlasHeight)
+    : tileWidth(tileWidth), tileHeight(tileHeight), atlasWidth(atlasWidth), atlasHeight(atlasHeight),
+      columns(atlasWidth / tileWidth), atlas{}, loaded(false), frame(1), renderCount(0) {
+    slots.resize((std::size_t)columns * (atlasHeight / tileHeight));
+}
+
+void TileCache::beginFrame() {
+    frame++;
+}
+
+bool TileCache::prepare(const Room& room) {
+    if (!loaded && !slots.empty()) {
+        // Created on first use, once the window and its GL context exist
+        atlas = LoadRenderTexture(atlasWidth, atlasHeight);
+        loaded = atlas.id != 0;
+        if (!loaded) {
+            slots.clear(); // No atlas: every tile is drawn directly
+        }
+    }
+    if (!loaded) {
+        return false;
+    }
+
+    std::size_t slot;
+    auto it = slotOfRoom.find(room.getName());
+    if (it != slotOfRoom.end()) {
+        slot = it->second;
+        slots[slot].lastFrame = frame;
+        if (slots[slot].version == room.getVersion()) {
+            return true;
+        }
+    } else {
+        // A free slot, or else the one unused for longest
+        std::size_t oldest = slots.size();
+        for (std::size_t i = 0; i < slots.size(); ++i) {
+            if (slots[i].room.empty()) {
+                oldest = i;
+                break;
+            }
+            if (slots[i].lastFrame < frame && (oldest == slots.size() || slots[i].lastFrame < slots[oldest].lastFrame)) {
+                oldest = i;
+            }
+        }
+        if (oldest == slots.size()) {
+            return false;
+        }
+        slot = oldest;
+        if (!slots[slot].room.empty()) {
+            slotOfRoom.erase(slots[slot].room);
+        }
+        slots[slot].room = room.getName();
+        slots[slot].lastFrame = frame;
+        slotOfRoom[slots[slot].room] = slot;
+    }
+
+    Rectangle target = slotRect(slot);
+    BeginTextureMode(atlas);
+    // Text edges are blended into the colour only; the slot's alpha stays opaque
+    rlSetBlendFactorsSeparate(RL_SRC_ALPHA, RL_ONE_MINUS_SRC_ALPHA, RL_ONE, RL_ONE_MINUS_SRC_ALPHA, RL_FUNC_ADD, RL_FUNC_ADD);
+    BeginBlendMode(BLEND_CUSTOM_SEPARATE);
+    drawTile(room, target.x, target.y, target.width, target.height);
+    EndBlendMode();
+    EndTextureMode();
+    slots[slot].version = room.getVersion();
+    renderCount++;
+    return true;
+}
+
+void TileCache::draw(const Room& room, float x, float y) {
+    auto it = slotOfRoom.find(room.getName());
+    if (it == slotOfRoom.end() || slots[it->second].lastFrame != frame || slots[it->second].version != room.getVersion()) {
+        drawTile(room, x, y, (float)tileWidth, (float)tileHeight);
+        return;
+    }
+    // Render textures are stored bottom-up, so the slot is read flipped
+    Rectangle source = slotRect(it->second);
+    source.y = atlasHeight - source.y - source.height;
+    source.height = -source.height;
+    DrawTextureRec(atlas.texture, source, Vector2{ x, y }, WHITE);
+}
+
+void TileCache::unload() {
+    if (loaded) {
+        UnloadRenderTexture(atlas);
+        loaded = false;
+    }
+    slotOfRoom.clear();
+    for (auto& slot : slots) {
+        slot = Slot();
+    }
+}
+
+std::uint64_t TileCache::getRenderCount() const {
+    return renderCount;
+}
+
+void TileCache::drawTile(const Room& room, float x, float y, float width, float height) {
+    Color roomColor = room.isAvailable() ? Color{18, 160, 14, 255} : Color{190, 30, 45, 255};
+    DrawRectangle(x, y, width, height, roomColor);
+    DrawRectangleLines(x, y, width, height, DARKBROWN);
+
+    DrawText(room.getName().c_str(), x + 10, y + 10, 20, WHITE);
+    DrawText(TextFormat("Capacity: %d", room.getCapacity()), x + 10, y + 35, 15, WHITE);
+
+    if (!room.isAvailable()) {
+        DrawText(TextFormat("Booked: %s", room.getBookedBy().c_str()), x + 10, y + 60, 15, YELLOW);
+    } else {
+        DrawText("Available", x + 10, y + 60, 15, WHITE);
+    }
+}
+
+Rectangle TileCache::slotRect(std::size_t slot) const {
+    return Rectangle{ (float)((int)(slot % columns) * tileWidth), (float)((int)(slot / columns) * tileHeight), (float)tileWidth, (float)tileHeight };
+}
@@ -1,6 +1,7 @@
 
 #include "ui.hpp"
 #include <iostream>
+#include <mutex>
 
 void UI::clearScreen() {
 #ifdef _WIN32
@@ -11,6 +12,8 @@ void UI::clearScreen() {
 }
 
 void UI::displayMessage(const std::string& message) {
+    static std::mutex outputMutex; // Keeps lines from parallel offline replay whole
+    std::lock_guard<std::mutex> lock(outputMutex);
     std::cout << message << std::endl;
 }
 
@@ -37,7 +40,8 @@ void UI::displayAdminMenu() {
     std::cout << "3. View Room" << std::endl;
     std::cout << "4. Register New Admin" << std::endl;
     std::cout << "5. Manage Offline Data" << std::endl;
-    std::cout << "6. Logout" << std::endl;
+    std::cout << "6. Import Users From File" << std::endl;
+    std::cout << "7. Logout" << std::endl;
     std::cout << "=========================================" << std::endl;
     std::cout << "Enter your choice: ";
 }
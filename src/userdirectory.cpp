@@ -0,0 +1,100 @@
+#include "userdirectory.hpp"
+#include <algorithm>
+
+namespace {
+
+bool entryLess(const UserDirectory::Entry& entry, const std::string& username) {
+    return entry.username < username;
+}
+
+} // namespace
+
+void UserDirectory::rebuild(std::vector<Entry> entries) {
+    std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.username < b.username; });
+    byRole.clear();
+    for (const auto& entry : entries) {
+        byRole[entry.role].push_back(entry); // Already in order
+    }
+    all = std::move(entries);
+    version++;
+}
+
+void UserDirectory::insertSorted(std::vector<Entry>& entries, const Entry& entry) {
+    auto it = std::lower_bound(entries.begin(), entries.end(), entry.username, entryLess);
+    if (it != entries.end() && it->username == entry.username) {
+        it->role = entry.role;
+    } else {
+        entries.insert(it, entry);
+    }
+}
+
+bool UserDirectory::eraseSorted(std::vector<Entry>& entries, const std::string& username) {
+    auto it = std::lower_bound(entries.begin(), entries.end(), username, entryLess);
+    if (it == entries.end() || it->username != username) {
+        return false;
+    }
+    entries.erase(it);
+    return true;
+}
+
+void UserDirectory::put(const std::string& username, int role) {
+    auto it = std::lower_bound(all.begin(), all.end(), username, entryLess);
+    if (it != all.end() && it->username == username) {
+        if (it->role == role) {
+            return;
+        }
+        eraseSorted(byRole[it->role], username); // Role changed
+        it->role = role;
+    } else {
+        all.insert(it, Entry{username, role});
+    }
+    insertSorted(byRole[role], Entry{username, role});
+    version++;
+}
+
+void UserDirectory::remove(const std::string& username) {
+    auto it = std::lower_bound(all.begin(), all.end(), username, entryLess);
+    if (it == all.end() || it->username != username) {
+        return;
+    }
+    eraseSorted(byRole[it->role], username);
+    all.erase(it);
+    version++;
+}
+
+// Every name starting with the prefix sorts into one contiguous range, found
+// with two binary searches.
+UserDirectory::Page UserDirectory::query(const std::string& prefix, int role, std::size_t offset, std::size_t limit) const {
+    Page page;
+    const std::vector<Entry>* entries = &all;
+    if (role != ANY_ROLE) {
+        auto roleIt = byRole.find(role);
+        if (roleIt == byRole.end()) {
+            return page;
+        }
+        entries = &roleIt->second;
+    }
+
+    const Entry* first = entries->data();
+    const Entry* last = entries->data() + entries->size();
+    if (!prefix.empty()) {
+        first = std::lower_bound(first, last, prefix, entryLess);
+        last = std::partition_point(first, last, [&prefix](const Entry& entry) {
+            return entry.username.compare(0, prefix.size(), prefix) == 0;
+        });
+    }
+
+    page.totalMatches = last - first;
+    page.offset = std::min(offset, page.totalMatches);
+    page.first = first + page.offset;
+    page.last = page.first + std::min(limit, page.totalMatches - page.offset);
+    return page;
+}
+
+std::size_t UserDirectory::size() const {
+    return all.size();
+}
+
+std::uint64_t UserDirectory::getVersion() const {
+    return version;
+}
@@ -0,0 +1,62 @@
+#include "virtuallist.hpp"
+#include "raygui.h"
+#include <algorithm>
+
+VirtualList::VirtualList(float rowHeight, int fontSize)
+    : rowHeight(rowHeight), fontSize(fontSize), maxWidth(0), scroll{ 0, 0 }, syncedVersion(0), synced(false) {}
+
+void VirtualList::clear() {
+    rows.clear();
+    maxWidth = 0;
+    scroll = { 0, 0 };
+    synced = false;
+}
+
+void VirtualList::append(const std::string& row) {
+    maxWidth = std::max(maxWidth, (float)MeasureText(row.c_str(), fontSize));
+    rows.push_back(row);
+}
+
+void VirtualList::sync(const std::vector<std::string>& source, std::uint64_t version) {
+    if (synced && syncedVersion == version) {
+        return;
+    }
+    // Comparing the first and last shown rows is enough for a source that appends
+    bool grown = !rows.empty() && source.size() >= rows.size() &&
+                 source.front() == rows.front() && source[rows.size() - 1] == rows.back();
+    if (!grown) {
+        Vector2 keptScroll = scroll;
+        clear();
+        scroll = keptScroll; // The panel clamps it if the list got shorter
+    }
+    for (std::size_t i = rows.size(); i < source.size(); ++i) {
+        append(source[i]);
+    }
+    syncedVersion = version;
+    synced = true;
+}
+
+void VirtualList::draw(Rectangle view, Color color) {
+    float contentWidth = (maxWidth > view.width) ? maxWidth + 20 : view.width;
+    Rectangle content = { 0, 0, contentWidth, (float)rows.size() * rowHeight };
+    Rectangle viewScroll = { 0, 0, 0, 0 };
+    GuiScrollPanel(view, NULL, content, &scroll, &viewScroll);
+
+    // Rows above and below the view are skipped rather than clipped
+    std::size_t first = (std::size_t)std::max(0.0f, (-scroll.y - 10) / rowHeight);
+    std::size_t last = std::min(rows.size(), (std::size_t)std::max(0.0f, (-scroll.y + view.height) / rowHeight) + 1);
+
+    BeginScissorMode(viewScroll.x, viewScroll.y, viewScroll.width, viewScroll.height);
+    for (std::size_t i = first; i < last; ++i) {
+        DrawText(rows[i].c_str(), view.x + 10 + scroll.x, view.y + 10 + i * rowHeight + scroll.y, fontSize, color);
+    }
+    EndScissorMode();
+}
+
+std::size_t VirtualList::size() const {
+    return rows.size();
+}
+
+bool VirtualList::empty() const {
+    return rows.empty();
+}